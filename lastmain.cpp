@@ -1,18 +1,38 @@
+// Для тактируемых лент яркость уходит в 5-битное поле каждого пикселя
+#define FASTLED_USE_GLOBAL_BRIGHTNESS 1
 #include <FastLED.h>
+#include <EEPROM.h>
+#include <SPI.h>
+#include <Wire.h>
+#include <atomic>
+#if defined(ESP32)
+#include <esp_task_wdt.h>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#endif
 
 /* ================= CONFIG ================= */
 
+// Профиль прежнего скетча поверх настроек ниже: 0 — этот (lastmain),
+// 1 — 1main (одна лента), 2 — 2main/4main, 3 — 3main
+#define VARIANT      0
+
 #define NUM_STRIPS   5
 #define NUM_LEDS     108
 
-#define LED_TYPE     WS2812
+#define LED_OUTPUT   OutClockless   // OutClockless, OutClocked, OutNull
+#define LED_TYPE     WS2812         // OutClockless
 #define COLOR_ORDER  GRB
+#define CLOCKED_TYPE  APA102        // OutClocked: APA102 или SK9822
+#define CLOCKED_ORDER BGR
+#define CLOCKED_MHZ   12
 
 #define DIR_RIGHT  1
 #define DIR_LEFT  -1
 
 #define DEMO_DELAY 25   // мс для демо-анимации
 #define GAME_DELAY 30   // мс для движения шарика в игре
+// Правила по умолчанию, если в EEPROM нет профиля
 #define SPEED_DELAY  30
 #define HIT_ZONE     3
 #define SCORE_STEP 10
@@ -20,17 +40,377 @@
 
 #define BRIGHTNESS 40
 
+#define GAME_MODE  ModeTeamMatch   // ModeClassic, ModeScoreZones, ModeTeamMatch, ModeMultiBall, ModeHandoff
+
+#define OVERRUN_LIMIT   8     // просроченных кадров подряд до понижения качества
+#define RECOVER_LIMIT   200   // быстрых кадров подряд до возврата качества
+#define WDT_TIMEOUT_S   3     // аппаратный watchdog, сек
+#define SLOW_SHOW_US    0     // искусственная задержка show() для проверки деградации
+
+#define BAR_GRADIENT     0    // 1 — полосы счёта с градиентом от края к центру
+#define BAR_PULSE_FRAMES 0    // кадров пульсации нового сегмента счёта, 0 — без анимации
+#define RENDER_STATS     0    // 1 — печатать среднее число записей пикселей за кадр
+
+#define COLOR_BG         CRGB::Black
+#define TRAIL_LEN        1    // длина кометы шарика, 6 — как в демо 2main
+#define TRAIL_FADE       40   // затухание кометы на шаг (как fadeToBlackBy)
+#define BALL_OVER_SCORE  160  // яркость шарика поверх полосы счёта, 255 — перекрывает
+#define FLASH_LEVEL      0    // вспышка дорожки цветом забившего, 0 — выключена
+#define FLASH_DECAY      24
+
+#define BUTTON_LOCKOUT   150  // мс после нажатия, когда кнопки дорожки игнорируются
+#define FRAME_HISTORY    8    // показанных кадров для поиска того, что видел игрок
+#define DISPLAY_EXTRA_US 0    // задержка после передачи до видимого кадра
+#define TIMING_LOG       0    // 1 — печатать оценку каждого нажатия
+#define LATENCY_TEST     0    // 1 — гистограмма задержки от нажатия BTN_L до видимой реакции
+#define LATENCY_REPORT   32   // нажатий между отчётами
+#define STATE_LOG        0    // 1 — печатать переходы автомата игры
+#define SCENARIO         0    // 1 — кнопки из сценария SCRIPT вместо пинов
+#define INVARIANT_CHECK  1    // проверять состояние дорожек после каждого кадра
+#define FRAME_HASH       0    // 64-битный отпечаток каждого кадра и всего прогона
+#define FRAME_HASH_LOG   0    // 1 — печатать отпечаток каждого кадра (FH:)
+#define SCENARIO_HASH    0    // ожидаемый хеш прогона сценария, 0 — только печать
+#define FRAME_VERIFY     0    // сверять дорожки после компоновки с полным пересчётом
+#define FRAME_TOLERANCE  0    // допуск канала при сверке для путей с другим округлением
+#define SOUND            0    // 1 — звуковые и вибро-сигналы событий
+#define SOUND_PIN        21   // пьезо/усилитель
+#define HAPTIC_PIN       22   // вибромотор через транзистор
+#define SOUND_QUEUE      16   // событий в очереди, степень двойки
+#define SOUND_STALE_MS   150  // сигнал старше этого уже не озвучиваем
+#define IDLE_AFTER_MS    60000 // без нажатий — демо переходит в экономный режим
+#define IDLE_DEMO_DELAY  100  // период кадра демо в экономном режиме
+#define IDLE_BRIGHTNESS  12
+#define IDLE_SLEEP       1    // 1 — light sleep между кадрами (ESP32)
+#define POWER_LOG        0    // 1 — раз в минуту печатать долю времени без сна
+#define CAPTURE          0    // 1 — поток показанных кадров в Serial (бинарный)
+#define CAPTURE_KEY_MS   5000 // период полного кадра для подключившихся позже
+
+#define DEMO_BREATH   0
+#define DEMO_COMET    1
+#define DEMO_STYLE    DEMO_BREATH // DEMO_BREATH — дыхание, DEMO_COMET — комета 2main/3main/4main
+#define DEMO_COMET_LEN 16         // длина кометы демо: до 1/16 яркости головы
+#define OVER_BLINK    0
+#define OVER_HOLD     1
+#define OVER_STYLE    OVER_BLINK  // OVER_BLINK — мигание цветом победителя, OVER_HOLD — дорожки держат свой цвет
+
 #define COLOR_LEFT   CRGB(0, 100, 0)
 #define COLOR_RIGHT  CRGB(0, 0, 100)
 #define COLOR_BALL   CRGB(255, 255, 255)
+#define COLOR_OBSTACLE CRGB(80, 0, 40)
+
+#define OBSTACLE_PERIOD 4   // шагов мяча на один шаг препятствия
+
+#define DIFFICULTY      0    // 1 — уровень дорожки по промахам и длине розыгрышей
+#define DIFF_MIN_LEVEL  -3   // ниже профиля — мяч медленнее
+#define DIFF_MAX_LEVEL  2    // выше — быстрее и уже зона
+#define DIFF_SPEED_DIV  8    // уровень меняет SPEED_DELAY на 1/8
+#define DIFF_MISS_LO    20   // % промахов: ниже — усложняем
+#define DIFF_MISS_HI    45   // выше — упрощаем
+#define DIFF_RALLY_HI   6    // средняя серия отбиваний, нужная для усложнения
+#define DIFF_HOLD       16   // событий после смены уровня до следующей
+#define DIFF_BACKOFF_MAX 5   // разворотов подряд, после которых выдержка не растёт
+#define DIFF_LOG        0    // 1 — печатать смену уровня
+
+#define INPUT_SOURCE InGpio      // InGpio, InShift165, InMcp23017
+#define SHIFT_LOAD_PIN 19        // InShift165: /PL цепочки
+#define SHIFT_CLK_PIN  23        // CLK цепочки (SCK)
+#define SHIFT_DATA_PIN 34        // Q7 последнего регистра (MISO)
+#define SHIFT_SPI_HZ   4000000
+#define MCP_ADDR       0x20      // InMcp23017: адрес первого расширителя
+#define MCP_I2C_HZ     400000
+#define MCP_SDA_PIN    19        // разъём кнопок тот же, что у 74HC165; 21/22 по
+#define MCP_SCL_PIN    23        // умолчанию Wire заняты SOUND_PIN и HAPTIC_PIN
+
+#define SHARD_SOLO    0
+#define SHARD_MASTER  1
+#define SHARD_SLAVE   2
+#define SHARD_ROLE    SHARD_SOLO  // SHARD_SOLO, SHARD_MASTER, SHARD_SLAVE
+#define SHARD_ID      0           // номер платы: 0 — ведущая, 1..SHARD_COUNT-1 — ведомые
+#define SHARD_COUNT   1           // плат в шкафу, на каждой NUM_STRIPS дорожек
+#define SHARD_BAUD    1000000
+#define SHARD_RX_PIN  35
+#define SHARD_TX_PIN  2
+#define SHARD_DE_PIN  -1          // RS-485: DE/RE приёмопередатчика, -1 — прямой UART
+#define SHARD_TIMEOUT_MS 200      // без тиков дольше — ведомая считает связь потерянной
+#define SHARD_SKEW_MAX_MS 50      // скачок часов ведущей больше — тик считаем битым
+
+// Пины по дорожкам, по одному на дорожку
+#define PINS_BTN_L   {4, 5, 6, 7, 8}          // InGpio
+#define PINS_BTN_R   {9, 10, 11, 12, 13}
+#define PINS_LED     {18, 17, 16, 15, 14}     // LAYOUT_IDENTITY: лента на дорожку
+#define PINS_CLK     {25, 26, 27, 32, 33}     // только OutClocked, программный SPI
+
+// Профили прежних скетчей: их правила по умолчанию, режим и разводка
+#if VARIANT == 1          // 1main: одна лента, очко — светодиод, до 10
+  #undef NUM_STRIPS
+  #define NUM_STRIPS   1
+  #undef PINS_BTN_L
+  #define PINS_BTN_L   {4}
+  #undef PINS_BTN_R
+  #define PINS_BTN_R   {6}
+  #undef PINS_LED
+  #define PINS_LED     {18}
+  #undef PINS_CLK
+  #define PINS_CLK     {25}
+  #undef GAME_MODE
+  #define GAME_MODE    ModeClassic
+  #undef SPEED_DELAY
+  #define SPEED_DELAY  40
+  #undef HIT_ZONE
+  #define HIT_ZONE     4
+  #undef SCORE_STEP
+  #define SCORE_STEP   1
+  #undef MAX_SCORE
+  #define MAX_SCORE    10
+  #undef COLOR_LEFT
+  #define COLOR_LEFT   CRGB(0, 128, 0)
+  #undef COLOR_RIGHT
+  #define COLOR_RIGHT  CRGB(255, 0, 0)
+  #undef OVER_STYLE
+  #define OVER_STYLE   OVER_HOLD
+#elif VARIANT == 2 || VARIANT == 3   // 2main/4main: зоны по счёту; 3main: зона у края, очко — светодиод
+  #undef GAME_MODE
+  #undef SCORE_STEP
+  #undef MAX_SCORE
+  #if VARIANT == 2
+    #define GAME_MODE  ModeScoreZones
+    #define SCORE_STEP 10
+    #define MAX_SCORE  50
+  #else
+    #define GAME_MODE  ModeClassic
+    #define SCORE_STEP 1
+    #define MAX_SCORE  10
+  #endif
+  #undef SPEED_DELAY
+  #define SPEED_DELAY  40
+  #undef HIT_ZONE
+  #define HIT_ZONE     3
+  #undef COLOR_LEFT
+  #define COLOR_LEFT   CRGB(0, 128, 0)
+  #undef COLOR_RIGHT
+  #define COLOR_RIGHT  CRGB(0, 0, 255)
+  #undef DEMO_DELAY
+  #define DEMO_DELAY   40            // демо шло с кадром игры
+  #undef DEMO_STYLE
+  #define DEMO_STYLE   DEMO_COMET
+  #undef OVER_STYLE
+  #define OVER_STYLE   OVER_HOLD
+#endif
+
+const uint8_t BTN_L[] = PINS_BTN_L;
+const uint8_t BTN_R[] = PINS_BTN_R;
+static_assert(sizeof(BTN_L) == NUM_STRIPS && sizeof(BTN_R) == NUM_STRIPS,
+              "PINS_BTN_L/PINS_BTN_R: по пину на каждую из NUM_STRIPS дорожек");
+
+/* ================= LAYOUT ================= */
+
+// Физическая разводка: дорожка (lane, pos) -> контроллер (пин) и смещение.
+// LAYOUT_IDENTITY 1 — каждая дорожка отдельная лента слева направо,
+// тогда px() сводится к leds[s][i] без таблицы.
+#define LAYOUT_IDENTITY 1
+#define LANE_SEGMENTS   2     // максимум кусков, на которые делится дорожка
+
+struct LaneSegment {
+  uint8_t  ctrl;       // контроллер
+  uint16_t offset;     // первый физический светодиод куска
+  uint16_t length;     // длина куска, 0 — не используется
+  bool     reversed;   // кусок проложен справа налево
+};
+
+#if LAYOUT_IDENTITY
+
+#define NUM_CONTROLLERS NUM_STRIPS
+#define CTRL_LEDS       NUM_LEDS
+
+constexpr uint8_t LED_PINS[] = PINS_LED;
+constexpr uint8_t CLK_PINS[] = PINS_CLK;
+static_assert(sizeof(LED_PINS) == NUM_CONTROLLERS && sizeof(CLK_PINS) == NUM_CONTROLLERS,
+              "PINS_LED/PINS_CLK: по пину на каждую ленту");
+
+// Дорожка s целиком на контроллере s, для любого NUM_STRIPS
+struct IdentityLayout {
+  LaneSegment at[NUM_STRIPS][LANE_SEGMENTS];
+
+  constexpr IdentityLayout() : at() {
+    for (int s = 0; s < NUM_STRIPS; s++)
+      for (int k = 0; k < LANE_SEGMENTS; k++)
+        at[s][k] = LaneSegment{ (uint8_t)s, 0, (uint16_t)(k == 0 ? NUM_LEDS : 0), false };
+  }
+  constexpr const LaneSegment *operator[](int s) const { return at[s]; }
+};
+
+constexpr IdentityLayout LANE_LAYOUT;
+
+#else
+
+// Новый шкаф: дорожки 0-1 и 3-4 — по одной ленте серпантином,
+// дорожка 2 разрезана пополам и запитана с обоих концов.
+#define NUM_CONTROLLERS 4
+#define CTRL_LEDS       (NUM_LEDS * 2)
+
+constexpr uint8_t LED_PINS[NUM_CONTROLLERS] = {18, 17, 16, 15};
+constexpr uint8_t CLK_PINS[NUM_CONTROLLERS] = {25, 26, 27, 32};
+
+constexpr LaneSegment LANE_LAYOUT[NUM_STRIPS][LANE_SEGMENTS] = {
+  { {0, 0,            NUM_LEDS,     false} },
+  { {0, NUM_LEDS,     NUM_LEDS,     true } },
+  { {1, 0,            NUM_LEDS / 2, false}, {2, 0, NUM_LEDS - NUM_LEDS / 2, true} },
+  { {3, 0,            NUM_LEDS,     false} },
+  { {3, NUM_LEDS,     NUM_LEDS,     true } },
+};
+
+#endif
+
+struct PhysAddr {
+  uint8_t  ctrl;
+  uint16_t offset;
+};
+
+// Таблица lane/pos -> физический адрес, строится при компиляции
+struct LayoutMap {
+  PhysAddr at[NUM_STRIPS][NUM_LEDS];
+
+  constexpr LayoutMap() : at() {
+    for (int s = 0; s < NUM_STRIPS; s++) {
+      int pos = 0;
+      for (int k = 0; k < LANE_SEGMENTS; k++) {
+        const LaneSegment &seg = LANE_LAYOUT[s][k];
+        for (int i = 0; i < seg.length && pos < NUM_LEDS; i++, pos++) {
+          at[s][pos].ctrl   = seg.ctrl;
+          at[s][pos].offset = seg.reversed ? seg.offset + seg.length - 1 - i
+                                           : seg.offset + i;
+        }
+      }
+    }
+  }
+};
+
+constexpr LayoutMap LAYOUT_MAP;
+
+constexpr uint16_t ctrlLength(int c) {
+  uint16_t len = 0;
+  for (int s = 0; s < NUM_STRIPS; s++)
+    for (int k = 0; k < LANE_SEGMENTS; k++)
+      if (LANE_LAYOUT[s][k].length && LANE_LAYOUT[s][k].ctrl == c &&
+          LANE_LAYOUT[s][k].offset + LANE_LAYOUT[s][k].length > len)
+        len = LANE_LAYOUT[s][k].offset + LANE_LAYOUT[s][k].length;
+  return len;
+}
+
+// Каждая позиция дорожки покрыта ровно одним куском,
+// куски не выходят за буфер контроллера и не перекрываются
+constexpr bool layoutValid() {
+  for (int s = 0; s < NUM_STRIPS; s++) {
+    int total = 0;
+    for (int k = 0; k < LANE_SEGMENTS; k++) {
+      const LaneSegment &a = LANE_LAYOUT[s][k];
+      if (!a.length) continue;
+      total += a.length;
+      if (a.ctrl >= NUM_CONTROLLERS || a.offset + a.length > CTRL_LEDS) return false;
+
+      for (int t = 0; t < NUM_STRIPS; t++)
+        for (int m = 0; m < LANE_SEGMENTS; m++) {
+          const LaneSegment &b = LANE_LAYOUT[t][m];
+          if ((t == s && m == k) || !b.length || b.ctrl != a.ctrl) continue;
+          if (a.offset < b.offset + b.length && b.offset < a.offset + a.length)
+            return false;
+        }
+    }
+    if (total != NUM_LEDS) return false;
+  }
+  return true;
+}
 
-const uint8_t LED_PINS[NUM_STRIPS] = {18, 17, 16, 15, 14};
-const uint8_t BTN_L[NUM_STRIPS]    = {4, 5, 6, 7, 8};
-const uint8_t BTN_R[NUM_STRIPS]    = {9, 10, 11, 12, 13};
+constexpr bool layoutIsIdentity() {
+  for (int s = 0; s < NUM_STRIPS; s++)
+    for (int i = 0; i < NUM_LEDS; i++)
+      if (LAYOUT_MAP.at[s][i].ctrl != s || LAYOUT_MAP.at[s][i].offset != i)
+        return false;
+  return true;
+}
+
+static_assert(layoutValid(), "LANE_LAYOUT: перекрытие или неполное покрытие дорожки");
+static_assert(!LAYOUT_IDENTITY || layoutIsIdentity(), "LAYOUT_IDENTITY не соответствует LANE_LAYOUT");
 
 /* ================= LED BUFFER ================= */
 
-CRGB leds[NUM_STRIPS][NUM_LEDS];
+CRGB leds[NUM_CONTROLLERS][CTRL_LEDS];
+
+inline CRGB &px(int s, int i) {
+#if LAYOUT_IDENTITY
+  return leds[s][i];
+#else
+  const PhysAddr &a = LAYOUT_MAP.at[s][i];
+  return leds[a.ctrl][a.offset];
+#endif
+}
+
+bool laneUsesCtrl(int s, int c) {
+  for (int k = 0; k < LANE_SEGMENTS; k++)
+    if (LANE_LAYOUT[s][k].length && LANE_LAYOUT[s][k].ctrl == c) return true;
+  return false;
+}
+
+/* ================= OUTPUT ================= */
+
+// Вывод кадра на ленты. Бэкенд выбирается LED_OUTPUT при компиляции:
+// регистрация контроллеров, показ всех лент или одной и время передачи
+// одного светодиода, из которого считается задержка кадра.
+// PARALLEL_SHOW — ленты передаются одновременно, и показ части лент
+// не быстрее показа всех
+
+// WS2812 и подобные: один провод данных, RMT, 800 кГц. FastLED.show()
+// запускает все каналы RMT сразу и ждёт последний; showLeds() одного
+// контроллера на ESP32 тоже ждёт остальные каналы
+struct OutClockless {
+  static constexpr uint32_t WIRE_NS_PER_LED = 30000;   // 24 бита по 1.25 мкс
+  static constexpr bool PARALLEL_SHOW = true;
+  static const char *name() { return "clockless"; }
+
+  template <int C> static void add() {
+    FastLED.addLeds<LED_TYPE, LED_PINS[C], COLOR_ORDER>(leds[C], ctrlLength(C));
+  }
+  static void show() { FastLED.show(); }
+  static void showCtrl(int c, uint8_t brightness) { FastLED[c].showLeds(brightness); }
+  // До регистрации: плавающий вход данных ленты ловит помехи
+  static void quiet(int c) {
+    pinMode(LED_PINS[c], OUTPUT);
+    digitalWrite(LED_PINS[c], LOW);
+  }
+};
+
+// APA102/SK9822: данные и такт. Программный SPI: аппаратных шин у ESP32
+// две (VSPI и HSPI), а лент пять, и FastLED ведёт аппаратно только пины
+// VSPI по умолчанию. На PINS_CLK он дёргает пины сам, и CLOCKED_MHZ —
+// лишь верхний предел; WIRE_NS_PER_LED по нему — оценка снизу, а OUT:
+// при запуске печатает измеренное время показа
+struct OutClocked : OutClockless {
+  static constexpr uint32_t WIRE_NS_PER_LED = 32 * 1000 / CLOCKED_MHZ;
+  static constexpr bool PARALLEL_SHOW = false;   // контроллеры по очереди
+  static const char *name() { return "clocked soft-spi"; }
+
+  template <int C> static void add() {
+    FastLED.addLeds<CLOCKED_TYPE, LED_PINS[C], CLK_PINS[C], CLOCKED_ORDER, DATA_RATE_MHZ(CLOCKED_MHZ)>(
+      leds[C], ctrlLength(C));
+  }
+  static void quiet(int c) {
+    OutClockless::quiet(c);
+    pinMode(CLK_PINS[c], OUTPUT);
+    digitalWrite(CLK_PINS[c], LOW);
+  }
+};
+
+// Без лент: кадры компонуются и попадают в CAPTURE, но не передаются
+struct OutNull {
+  static constexpr uint32_t WIRE_NS_PER_LED = 0;
+  static constexpr bool PARALLEL_SHOW = true;
+  static const char *name() { return "null"; }
+
+  template <int C> static void add() {}
+  static void show() {}
+  static void showCtrl(int, uint8_t) {}
+  static void quiet(int) {}
+};
 
 /* ================= STATES ================= */
 
@@ -48,8 +428,82 @@ enum GameState {
 
 GlobalState globalState = G_DEMO;
 
+void setGlobalState(GlobalState st) {
+#if STATE_LOG
+  Serial.print("STATE: ");
+  Serial.print(globalState);
+  Serial.print(" -> ");
+  Serial.print(st);
+  Serial.print(" @");
+  Serial.println(millis());
+#endif
+  globalState = st;
+}
+
+/* ================= GAME MODES ================= */
+
+// Дорожек во всём шкафу: на ведущей и ведомых платах по NUM_STRIPS
+#define TOTAL_LANES (NUM_STRIPS * SHARD_COUNT)
+
+// Режим — набор статических правил; кнопки, дорожки и конец матча
+// инстанцируются только для выбранного GAME_MODE. Цена очка и длина
+// матча задаются профилем правил (SCORE_STEP, MAX_SCORE)
+
+// Зона отбивания у самого края ленты, матч до конца всех дорожек
+struct ModeClassic {
+  static constexpr int EXTRA_BALLS = 0;
+  static constexpr int OBSTACLES = 0;
+  static constexpr int VISITORS = 0;     // мест для мячей, пришедших с соседних дорожек
+  static constexpr bool MAJORITY = false; // конец матча по большинству дорожек
+  static int zoneShift(int score) { return 0; }
+  static bool matchOver(int leftWins, int rightWins) {
+    return leftWins + rightWins >= TOTAL_LANES;
+  }
+};
+
+// Зона сдвигается к центру вместе с полосой счёта
+struct ModeScoreZones {
+  static constexpr int EXTRA_BALLS = 0;
+  static constexpr int OBSTACLES = 0;
+  static constexpr int VISITORS = 0;     // мест для мячей, пришедших с соседних дорожек
+  static constexpr bool MAJORITY = false;
+  static int zoneShift(int score) { return score; }
+  static bool matchOver(int leftWins, int rightWins) {
+    return leftWins + rightWins >= TOTAL_LANES;
+  }
+};
+
+#define MATCH_LANES (TOTAL_LANES / 2 + 1)
+
+// Командный матч: зоны по счёту, конец по большинству дорожек
+struct ModeTeamMatch : ModeScoreZones {
+  static constexpr bool MAJORITY = true;
+  static bool matchOver(int leftWins, int rightWins) {
+    return leftWins >= MATCH_LANES || rightWins >= MATCH_LANES;
+  }
+};
+
+// Командный матч с дополнительными мячами и движущимися препятствиями
+struct ModeMultiBall : ModeTeamMatch {
+  static constexpr int EXTRA_BALLS = 2;
+  static constexpr int OBSTACLES = 2;
+};
+
+// Мяч, вылетевший за край, кроме очка сопернику продолжает путь
+// с дальнего края соседней дорожки
+struct ModeHandoff : ModeTeamMatch {
+  static constexpr int VISITORS = 3;
+};
+
 /* ================= GAME STRUCT ================= */
 
+enum HitGrade {
+  HIT_EARLY,
+  HIT_PERFECT,
+  HIT_LATE,
+  HIT_MISS
+};
+
 struct StripGame {
   GameState state;
   int ballPos;
@@ -58,275 +512,2744 @@ struct StripGame {
   int scoreR;
   unsigned long lastMove;
   unsigned long lastButton;
+  HitGrade lastGrade;
+  int zoneL;             // первые клетки зон отбивания, длина зоны hitZone + 1;
+  int zoneR;             // пересчитываются только при смене счёта
+  int hitZone;           // правила с поправкой на уровень дорожки
+  unsigned long speedDelay;
 };
 
 StripGame game[NUM_STRIPS];
 
+// Дополнительные объекты дорожки: мячи и препятствия. Пул фиксированного
+// размера на дорожку, ёмкость задаёт режим, памяти не выделяем
+enum ObjectKind : uint8_t { OBJ_BALL, OBJ_OBSTACLE };
+
+struct LaneObject {
+  int16_t pos;
+  int16_t shownPos;      // где объект нарисован сейчас
+  int8_t dir;
+  ObjectKind kind;
+  uint8_t id;            // постоянный номер, пока объект на дорожке: по нему история кадров
+  int16_t hitAt;         // клетка препятствия, с которым столкнулся на этом шаге, иначе -1
+  bool visitor;          // пришёл с соседней дорожки, после вылета не возвращается
+};
+
+constexpr int OBJ_POOL = GAME_MODE::EXTRA_BALLS + GAME_MODE::OBSTACLES + GAME_MODE::VISITORS;
+
+struct ObjectPool {
+  LaneObject obj[OBJ_POOL > 0 ? OBJ_POOL : 1];
+  uint8_t count;         // занятые слоты, отсортированы по pos
+  uint8_t tick;          // счётчик шагов для препятствий
+};
+
+ObjectPool pools[NUM_STRIPS];
+
+// Состояние слоёв дорожки. Кадр перекомпоновывается только в диапазоне
+// [dirtyLo, dirtyHi], где слои изменились с прошлого кадра
+struct LaneRender {
+  int barL;              // слой счёта: длина полос
+  int barR;
+  uint8_t pulseL;        // оставшиеся кадры анимации нового сегмента
+  uint8_t pulseR;
+  int ballPos;           // слой шарика: голова кометы, её направление и длина
+  int ballDir;
+  uint8_t trailLen;      // TRAIL_LEN в игре, DEMO_COMET_LEN в демо
+  uint8_t flashSlot;     // слой эффектов: слот палитры и уровень
+  uint8_t flash;
+  int dirtyLo;
+  int dirtyHi;
+  CRGB fill;             // заливка всей дорожки поверх остальных слоёв
+  bool filled;
+  bool needsReset;       // дорожку нужно перерисовать целиком
+};
+
+LaneRender laneRender[NUM_STRIPS];
+uint32_t pixelWrites = 0;
+
 /* ================= GLOBAL ANIM ================= */
 
-int fillPos = 0;
+// Анимации переходов пишутся линейно как сопрограммы без стека: всё
+// состояние — строка, на которой остановились, начало и длина ожидания
+// и счётчик цикла. Функция-сценарий возвращает true, когда нарисовала
+// кадр, и продолжает с того же места при следующем вызове из loop().
+// Опрос во время ожидания — одно сравнение до switch, как у прежних
+// автоматов на millis() (test/host/bench_timeline).
+// Локальные переменные между вызовами не сохраняются — только поля Timeline
+struct Timeline {
+  uint16_t line;
+  uint16_t waitMs;       // 0 — не ждём
+  unsigned long waitFrom;
+  int i;
+};
+
+#define TL_BEGIN(t)      if ((t).waitMs && millis() - (t).waitFrom < (t).waitMs) return false; \
+                         switch ((t).line) { case 0:
+#define TL_END(t)        } (t).line = 0; return false
+// Показать нарисованное и продолжить через ms
+#define TL_FRAME(t, ms)  (t).waitFrom = millis(); (t).waitMs = (ms); (t).line = __LINE__; return true; \
+                         case __LINE__: (t).waitMs = 0
+// Подождать ms, ничего не показывая
+#define TL_WAIT(t, ms)   (t).waitFrom = millis(); (t).waitMs = (ms); (t).line = __LINE__; return false; \
+                         case __LINE__: (t).waitMs = 0
+#define TL_YIELD(t)      (t).line = __LINE__; return false; case __LINE__:
+
+Timeline anim;                        // сценарий текущего перехода
 CRGB gameOverColor = CRGB::Black;
-int blinkCount = 0;
-bool blinkState = false;
-unsigned long lastBlink = 0;
 
-/* ================= SETUP ================= */
+/* ================= SCORE LAYER ================= */
 
-void setup() {
-  FastLED.setBrightness(BRIGHTNESS);
+// Яркость полосы счёта от края к центру, цвет берётся из палитры дорожки
+#define BAR_MAX (NUM_LEDS / 2)
 
-  FastLED.addLeds<WS2812, 18, GRB>(leds[0], NUM_LEDS);
-  FastLED.addLeds<WS2812, 17, GRB>(leds[1], NUM_LEDS);
-  FastLED.addLeds<WS2812, 16, GRB>(leds[2], NUM_LEDS);
-  FastLED.addLeds<WS2812, 15, GRB>(leds[3], NUM_LEDS);
-  FastLED.addLeds<WS2812, 14, GRB>(leds[4], NUM_LEDS);
+struct BarLevels {
+  uint8_t at[BAR_MAX];
 
-  for (int s = 0; s < NUM_STRIPS; s++) {
-    pinMode(BTN_L[s], INPUT_PULLUP);
-    pinMode(BTN_R[s], INPUT_PULLUP);
+  constexpr BarLevels() : at() {
+    for (int i = 0; i < BAR_MAX; i++)
+      at[i] = BAR_GRADIENT ? 64 + i * 191 / (BAR_MAX - 1) : 255;
   }
+};
+
+constexpr BarLevels BAR_LEVELS;
+
+/* ================= PALETTE ================= */
+
+// 16-цветные палитры во flash. Слои хранят номер слота палитры,
+// в CRGB цвет превращается только при компоновке кадра.
+enum PaletteSlot {
+  PAL_BG,
+  PAL_LEFT,
+  PAL_RIGHT,
+  PAL_BALL,
+  PAL_OBSTACLE,
+  PAL_SLOTS
+};
+
+#define PAL_CUSTOM   0   // палитра из цветов профиля правил
+#define NUM_PALETTES 4
+
+const TProgmemRGBPalette16 PAL_CLASSIC PROGMEM = {   // 3main / 4main
+  0x000000, 0x008000, 0x0000FF, 0xFFFFFF, 0x500028
+};
+
+const TProgmemRGBPalette16 PAL_DUEL PROGMEM = {      // 1main
+  0x000000, 0x008000, 0xFF0000, 0xFFFFFF, 0x500028
+};
+
+const TProgmemRGBPalette16 PAL_NIGHT PROGMEM = {
+  0x000000, 0x301800, 0x001830, 0x505050, 0x200010
+};
 
-  FastLED.clear();
-  FastLED.show();
+const TProgmemRGBPalette16 *const PALETTES[NUM_PALETTES] = {
+  NULL, &PAL_CLASSIC, &PAL_DUEL, &PAL_NIGHT
+};
+
+CRGB laneColors[NUM_STRIPS][PAL_SLOTS];   // развёрнутые слоты палитры дорожки
+
+inline const CRGB &laneColor(int s, uint8_t slot) {
+  return laneColors[s][slot];
 }
 
-/* ================= DEMO ================= */
+void loadLaneColors(int s, uint8_t pal, const CRGB custom[PAL_SLOTS]) {
+  for (int k = 0; k < PAL_SLOTS; k++)
+    laneColors[s][k] = (pal == PAL_CUSTOM) ? custom[k]
+                                           : CRGB(pgm_read_dword(&(*PALETTES[pal])[k]));
+}
 
-void demoAnimation() {
-  // Проверка кнопок
-  for (int s = 0; s < NUM_STRIPS; s++) {
-    if (!digitalRead(BTN_L[s]) || !digitalRead(BTN_R[s])) {
-      globalState = G_START_FILL;
-      fillPos = 0;
-      FastLED.clear();
-      return;
-    }
-  }
+// RAM цветов слоя счёта до палитр: общий barCache[2][BAR_MAX] в CRGB и
+// CRGB вспышки в каждой дорожке. После: слоты палитры и байт слота
+// вспышки на дорожку, градиент BAR_LEVELS — constexpr во flash.
+// Слоты растут с числом дорожек, поэтому выигрыш зависит от конфигурации
+// (5 дорожек по 108: 339 B -> 80 B)
+constexpr size_t SCORE_COLORS_BEFORE_BYTES = 2 * BAR_MAX * sizeof(CRGB) + NUM_STRIPS * sizeof(CRGB);
+constexpr size_t SCORE_COLORS_AFTER_BYTES  = sizeof(laneColors) + NUM_STRIPS * sizeof(uint8_t);
+
+void reportPaletteRam() {
+  Serial.print("PALETTE: score colors ");
+  Serial.print(SCORE_COLORS_AFTER_BYTES);
+  Serial.print(" B, barCache was ");
+  Serial.print(SCORE_COLORS_BEFORE_BYTES);
+  Serial.println(" B");
+}
 
-  // ===== Плавное дыхание =====
-  static uint8_t step = 2;
-  static int dir = 1;
-  const int minB = 15;
-  const int maxB = 50;
-  const int stepsCount = 20;
+/* ================= RULES ================= */
+
+// Профиль правил: хранится в EEPROM, может прийти по Serial.
+// Новый профиль применяется только между матчами.
+#define RULES_MAGIC    0x5054   // "PT"
+#define RULES_VERSION  2
+#define RULES_ADDR     0
+#define RULES_LINE_MAX 64
+
+struct RuleProfile {
+  uint8_t  hitZone;
+  uint8_t  scoreStep;
+  uint16_t maxScore;
+  uint16_t speedDelay;
+  CRGB colorLeft;
+  CRGB colorRight;
+  CRGB colorBall;
+  uint8_t lanePalette[NUM_STRIPS];
+};
 
-  float brightness = minB + (maxB - minB) * step / float(stepsCount);
+struct RulesRecord {
+  uint16_t magic;
+  uint8_t  version;
+  RuleProfile profile;
+  uint8_t  checksum;
+};
 
-  for (int s = 0; s < NUM_STRIPS; s++) {
-    fill_solid(leds[s], NUM_LEDS, CRGB(brightness, brightness, brightness));
+// Активные правила: профиль плюс значения, посчитанные при загрузке
+struct ActiveRules {
+  int hitZone;
+  int scoreStep;
+  int maxScore;
+  unsigned long speedDelay;
+  CRGB colorLeft;
+  CRGB colorRight;
+  CRGB colorBall;
+};
+
+ActiveRules rules;
+RuleProfile activeProfile;
+RuleProfile pendingRules;
+bool rulesPending = false;
+
+const RuleProfile DEFAULT_RULES = {
+  HIT_ZONE, SCORE_STEP, MAX_SCORE, SPEED_DELAY,
+  COLOR_LEFT, COLOR_RIGHT, COLOR_BALL,
+  { PAL_CUSTOM }
+};
+
+static_assert(2 * ((MAX_SCORE - 1) / SCORE_STEP * SCORE_STEP + HIT_ZONE + 1) < NUM_LEDS,
+              "правила по умолчанию: полосы счёта пересекаются");
+
+uint8_t rulesChecksum(const RuleProfile &p) {
+  const uint8_t *b = (const uint8_t *)&p;
+  uint8_t sum = 0;
+  for (size_t i = 0; i < sizeof(p); i++) sum = (sum << 1 | sum >> 7) ^ b[i];
+  return sum;
+}
+
+// Полосы счёта и зоны отбивания обеих сторон не должны пересекаться
+// ни при каком счёте, пока идёт игра
+bool rulesValid(const RuleProfile &p) {
+  if (p.scoreStep == 0 || p.speedDelay == 0 || p.maxScore < p.scoreStep) return false;
+  for (int s = 0; s < NUM_STRIPS; s++)
+    if (p.lanePalette[s] >= NUM_PALETTES) return false;
+  int maxPlayScore = (p.maxScore - 1) / p.scoreStep * p.scoreStep;
+  return 2 * (maxPlayScore + p.hitZone + 1) < NUM_LEDS;
+}
+
+void applyRules(const RuleProfile &p) {
+  rules.hitZone         = p.hitZone;
+  rules.scoreStep       = p.scoreStep;
+  rules.maxScore        = p.maxScore;
+  rules.speedDelay      = p.speedDelay;
+  rules.colorLeft       = p.colorLeft;
+  rules.colorRight      = p.colorRight;
+  rules.colorBall       = p.colorBall;
+  activeProfile         = p;
+
+  const CRGB custom[PAL_SLOTS] = { COLOR_BG, p.colorLeft, p.colorRight, p.colorBall, COLOR_OBSTACLE };
+  for (int s = 0; s < NUM_STRIPS; s++)
+    loadLaneColors(s, p.lanePalette[s], custom);
+}
+
+// Вызывается при старте матча
+void applyPendingRules() {
+  if (!rulesPending) return;
+  rulesPending = false;
+  applyRules(pendingRules);
+  Serial.println("RULES: applied");
+}
+
+// Профиль из EEPROM читается уже после первого кадра, до этого игра
+// идёт по DEFAULT_RULES. Как и профиль из Serial, он ставится в очередь:
+// если матч уже начался, применится со следующего
+void loadRules() {
+  RulesRecord rec;
+#if defined(ESP32)
+  EEPROM.begin(sizeof(RulesRecord));
+#endif
+  EEPROM.get(RULES_ADDR, rec);
+
+  if (rec.magic == RULES_MAGIC && rec.version == RULES_VERSION &&
+      rec.checksum == rulesChecksum(rec.profile) && rulesValid(rec.profile)) {
+    pendingRules = rec.profile;
+    rulesPending = true;
+    Serial.println("RULES: loaded");
+    if (globalState == G_DEMO) applyPendingRules();
+  } else {
+    Serial.println("RULES: defaults");
   }
+}
 
-  step += dir;
-  if (step >= stepsCount) dir = -1;
-  if (step <= 0) dir = 1;
+void saveRules(const RuleProfile &p) {
+  RulesRecord rec;
+  rec.magic    = RULES_MAGIC;
+  rec.version  = RULES_VERSION;
+  rec.profile  = p;
+  rec.checksum = rulesChecksum(p);
+  EEPROM.put(RULES_ADDR, rec);
+#if defined(ESP32)
+  EEPROM.commit();
+#endif
 }
 
-/* ================= START FILL ================= */
+// Число от 0 до max. strtoul принимает знак ("-1" — это ULONG_MAX) и
+// при переполнении тоже даёт ULONG_MAX, поэтому знак отсекается до него,
+// а всё больше max — после, до сужения в поля профиля
+bool parseField(char *&cur, int base, unsigned long max, unsigned long &v) {
+  while (*cur == ' ') cur++;
+  unsigned char c = *cur;
+  if (!(base == 16 ? isxdigit(c) : isdigit(c))) return false;
+  char *end;
+  v = strtoul(cur, &end, base);
+  if (v > max) return false;
+  cur = end;
+  return true;
+}
 
-void startFillAnimation() {
-  static unsigned long lastFillUpdate = 0;
-  const unsigned long fillDelay = 20;
+// Строка вида
+//   RULES <hitZone> <scoreStep> <maxScore> <speedDelay> <RRGGBB> <RRGGBB> <RRGGBB> [SAVE]
+bool parseRulesLine(char *line, RuleProfile &p, bool &save) {
+  if (strncmp(line, "RULES ", 6) != 0) return false;
+
+  static const unsigned long MAX[7] = { UINT8_MAX, UINT8_MAX, UINT16_MAX, UINT16_MAX,
+                                        0xFFFFFF, 0xFFFFFF, 0xFFFFFF };
+  unsigned long v[7];
+  char *cur = line + 6;
+  for (int k = 0; k < 7; k++)
+    if (!parseField(cur, k < 4 ? 10 : 16, MAX[k], v[k])) return false;
+
+  p.hitZone    = v[0];
+  p.scoreStep  = v[1];
+  p.maxScore   = v[2];
+  p.speedDelay = v[3];
+  p.colorLeft  = CRGB((uint32_t)v[4]);
+  p.colorRight = CRGB((uint32_t)v[5]);
+  p.colorBall  = CRGB((uint32_t)v[6]);
+  save = strstr(cur, "SAVE") != NULL;
+  return true;
+}
 
-  unsigned long now = millis();
-  if (now - lastFillUpdate < fillDelay) return;
-  lastFillUpdate = now;
+// Строка вида
+//   PALETTE <палитра дорожки 0> ... <палитра дорожки N-1> [SAVE]
+bool parsePaletteLine(char *line, RuleProfile &p, bool &save) {
+  if (strncmp(line, "PALETTE ", 8) != 0) return false;
 
+  char *cur = line + 8;
   for (int s = 0; s < NUM_STRIPS; s++) {
-    for (int i = 0; i <= fillPos; i++) {
-      leds[s][i] = COLOR_LEFT;
-      leds[s][NUM_LEDS - 1 - i] = COLOR_RIGHT;
-    }
+    unsigned long v;
+    if (!parseField(cur, 10, NUM_PALETTES - 1, v)) return false;
+    p.lanePalette[s] = v;
   }
+  save = strstr(cur, "SAVE") != NULL;
+  return true;
+}
 
-  fillPos++;
+// Неблокирующий приём профиля по Serial
+void pollSerialRules() {
+  static char line[RULES_LINE_MAX];
+  static uint8_t len = 0;
 
-  if (fillPos >= NUM_LEDS / 2) {
-    for (int s = 0; s < NUM_STRIPS; s++) {
-      game[s].state      = PLAYING;
-      game[s].ballPos    = NUM_LEDS / 2;
-      game[s].direction  = (s % 2 == 0) ? 1 : -1;
-      game[s].scoreL     = 0;
-      game[s].scoreR     = 0;
-      game[s].lastMove   = millis();
-      game[s].lastButton = 0;
+  while (Serial.available() > 0) {
+    char c = Serial.read();
+    if (c != '\n' && c != '\r') {
+      if (len < RULES_LINE_MAX - 1) line[len++] = c;
+      continue;
+    }
+    if (len == 0) continue;
+    line[len] = 0;
+    len = 0;
+
+    RuleProfile p = rulesPending ? pendingRules : activeProfile;
+    bool save = false;
+    if (!parseRulesLine(line, p, save) && !parsePaletteLine(line, p, save)) continue;
+
+    if (!rulesValid(p)) {
+      Serial.println("RULES: rejected");
+      continue;
     }
-    globalState = G_PLAYING;
+    if (save) saveRules(p);
+    pendingRules = p;
+    rulesPending = true;
+    Serial.println("RULES: pending");
   }
 }
 
-/* ================= DRAW SCORE ================= */
-
-void drawScores(int s) {
-  for (int i = 0; i < game[s].scoreL; i++)
-    leds[s][i] = COLOR_LEFT;
+/* ================= CAPTURE ================= */
+
+// Поток показанных кадров в координатах дорожек, только изменения
+// относительно уже отправленного. Формат (числа little-endian):
+//   A5 5A 'H' lanes:u8 leds:u16                — заголовок, с каждым полным кадром
+//   A5 5A 'F' ms:u32 { op } FF                 — кадр
+//   op: lane:u8 start:u16 len:u8 rgb×len       — участок пикселей
+//       lane|80 start:u16 len:u8 rgb           — участок одного цвета
+// Пишем только то, что влезает в буфер передачи, Serial не ждём:
+// не влезшие изменения уйдут со следующим кадром. Текстовые логи при
+// этом лучше выключить, читатель находит кадры по A5 5A. Разбор потока —
+// test/host/capture_decode.h, перевод в Y4M/PPM — test/host/capture_convert
+#if CAPTURE
+#define CAPTURE_LITERAL 32   // пикселей в одном разнородном участке
+
+CRGB captured[NUM_STRIPS][NUM_LEDS];
+bool captureAll[NUM_STRIPS];      // дорожка отправляется целиком (полный кадр)
+bool captureKeyDue = true;
+unsigned long lastKeyFrame = 0;
+
+void captureWrite16(uint16_t v) {
+  Serial.write((uint8_t)v);
+  Serial.write((uint8_t)(v >> 8));
+}
 
-  for (int i = 0; i < game[s].scoreR; i++)
-    leds[s][NUM_LEDS - 1 - i] = COLOR_RIGHT;
+inline bool captureChanged(int s, int i) {
+  return captureAll[s] || px(s, i) != captured[s][i];
 }
 
-/* ================= BUTTONS ================= */
+void captureRun(int s, int lo, int len, bool uniform) {
+  Serial.write((uint8_t)(s | (uniform ? 0x80 : 0)));
+  captureWrite16(lo);
+  Serial.write((uint8_t)len);
+  for (int i = lo; i < lo + len; i++) {
+    if (!uniform || i == lo) Serial.write(px(s, i).raw, 3);
+    captured[s][i] = px(s, i);
+  }
+}
 
-void handleButtons(int s, unsigned long now) {
-  if (now - game[s].lastButton < 150) return;
-
-  int leftZoneStart  = game[s].scoreL;
-  int leftZoneEnd    = game[s].scoreL + HIT_ZONE;
-  int rightZoneEnd   = NUM_LEDS - 1 - game[s].scoreR;
-  int rightZoneStart = rightZoneEnd - HIT_ZONE;
-
-  if (!digitalRead(BTN_L[s])) {
-    game[s].lastButton = now;
-    if (game[s].ballPos >= leftZoneStart && game[s].ballPos <= leftZoneEnd)
-      game[s].direction = DIR_RIGHT;
-    else {
-      game[s].scoreR += SCORE_STEP;
-      game[s].ballPos = NUM_LEDS / 2;
-      game[s].direction = DIR_RIGHT;
+// Участки одного цвета от трёх пикселей идут заливкой, остальное —
+// короткими списками. false, если кадр не влез и дорожка не дописана
+bool captureLane(int s, int &budget) {
+  int i = 0;
+  while (i < NUM_LEDS) {
+    if (!captureChanged(s, i)) { i++; continue; }
+
+    int j = i + 1;
+    while (j < NUM_LEDS && j - i < 255 && px(s, j) == px(s, i) && captureChanged(s, j)) j++;
+    bool uniform = j - i >= 3;
+    if (!uniform) {
+      j = i + 1;
+      while (j < NUM_LEDS && j - i < CAPTURE_LITERAL && captureChanged(s, j) &&
+             !(j + 2 < NUM_LEDS && px(s, j) == px(s, j + 1) && px(s, j) == px(s, j + 2))) j++;
     }
+
+    int cost = uniform ? 7 : 4 + 3 * (j - i);
+    if (cost > budget) return false;
+    budget -= cost;
+    captureRun(s, i, j - i, uniform);
+    i = j;
+  }
+  captureAll[s] = false;
+  return true;
+}
+#endif
+
+void captureFrame() {
+#if CAPTURE
+  unsigned long now = millis();
+  bool key = captureKeyDue || now - lastKeyFrame >= CAPTURE_KEY_MS;
+  if (key) {
+    lastKeyFrame = now;
+    captureKeyDue = false;
+    for (int s = 0; s < NUM_STRIPS; s++) captureAll[s] = true;
+  }
+
+  int budget = Serial.availableForWrite() - 8 - (key ? 6 : 0);
+  if (budget < 16) return;
+
+  const uint8_t sync[] = { 0xA5, 0x5A };
+  if (key) {
+    Serial.write(sync, 2);
+    Serial.write('H');
+    Serial.write((uint8_t)NUM_STRIPS);
+    captureWrite16(NUM_LEDS);
   }
+  Serial.write(sync, 2);
+  Serial.write('F');
+  captureWrite16(now);
+  captureWrite16(now >> 16);
+
+  for (int s = 0; s < NUM_STRIPS; s++)
+    if (!captureLane(s, budget)) break;
+  Serial.write(0xFF);
+#endif
+}
+
+/* ================= FRAME HASH ================= */
+
+// 64-битный отпечаток каждого скомпонованного кадра (весь leds[][]) и
+// цепочка отпечатков за прогон. Рефакторинг вывода не должен менять ни
+// одного кадра: сценарий SCENARIO печатает число кадров и хеш прогона
+// и сравнивает его с SCENARIO_HASH. Число кадров сценария зависит от
+// времени show(), поэтому хеш у платы и у хоста свой: хостовый задаёт
+// вариант frame_hash в test/host/CMakeLists.txt
+struct FrameHash {
+  uint64_t last;    // отпечаток последнего кадра
+  uint64_t run;     // цепочка с начала прогона
+  uint32_t frames;
+  unsigned long us; // время хеширования для RENDER:
+};
 
-  if (!digitalRead(BTN_R[s])) {
-    game[s].lastButton = now;
-    if (game[s].ballPos >= rightZoneStart && game[s].ballPos <= rightZoneEnd)
-      game[s].direction = DIR_LEFT;
-    else {
-      game[s].scoreL += SCORE_STEP;
-      game[s].ballPos = NUM_LEDS / 2;
-      game[s].direction = DIR_LEFT;
+FrameHash fh = { 0, 0x84222325CBF29CE4ULL, 0, 0 };
+
+// Четыре независимые цепочки по 32-битным словам не ждут умножений
+// друг друга: на ESP32 это конвейер, на ПК цикл векторизуется.
+// Перемешивание в конце — финализатор splitmix64
+uint64_t frameHash64(const uint8_t *p, size_t n) {
+  uint32_t h[4] = { 0x811C9DC5, 0x9E3779B9, 0x85EBCA6B, 0xC2B2AE35 };
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    for (int k = 0; k < 4; k++) {
+      uint32_t w;
+      memcpy(&w, p + i + 4 * k, 4);
+      h[k] = (h[k] ^ w) * 0x01000193;
     }
   }
+  for (; i < n; i++) h[i & 3] = (h[i & 3] ^ p[i]) * 0x01000193;
+
+  uint64_t x = ((uint64_t)h[0] << 32 | h[1]) ^ ((uint64_t)h[2] << 32 | h[3]) * 0x9E3779B97F4A7C15ULL;
+  x ^= n;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
 }
 
-/* ================= PLAY GAME ================= */
+void printHash(uint64_t h) {
+  char buf[17];
+  for (int k = 15; k >= 0; k--, h >>= 4) buf[k] = "0123456789abcdef"[h & 15];
+  buf[16] = 0;
+  Serial.print(buf);
+}
 
-// ================= PLAY GAME =================
-void updateStrip(int s, unsigned long now) {
-  StripGame &g = game[s];
+void hashFrame() {
+#if FRAME_HASH
+  unsigned long t = micros();
+  fh.last = frameHash64((const uint8_t *)leds, sizeof(leds));
+  fh.run = (fh.run ^ fh.last) * 0x100000001B3ULL;
+  fh.frames++;
+  fh.us += micros() - t;
+#if FRAME_HASH_LOG
+  Serial.print("FH: ");
+  Serial.print(fh.frames);
+  Serial.print(' ');
+  printHash(fh.last);
+  Serial.println();
+#endif
+#endif
+}
 
-  if (g.state == GAME_OVER) {
-    // Если левая сторона выиграла
-    if (g.scoreL >= MAX_SCORE) fill_solid(leds[s], NUM_LEDS, COLOR_LEFT);
-    // Если правая сторона выиграла
-    else if (g.scoreR >= MAX_SCORE) fill_solid(leds[s], NUM_LEDS, COLOR_RIGHT);
-    return;
+/* ================= COMPOSITOR ================= */
+
+// Кадр дорожки хранится не пикселями, а слоями: заливка (демо, GAME_OVER)
+// или фон + полосы счёта как отрезки одного цвета, шарик с кометой
+// (additive) и вспышка (alpha). В буфер ленты они разворачиваются только
+// перед show() и только в грязном диапазоне; буфер ленты не читается.
+// Состояние слоёв — несколько десятков байт на дорожку, но leds[] остаётся
+// полноразмерным (3 байта на светодиод): RMT/I2S FastLED читают его во
+// время передачи. CAPTURE добавляет ещё столько же в captured[].
+// От сцены зависит время развёртки, а не память: общий буфер передачи
+// на все контроллеры потребовал бы разворачивать каждую ленту целиком
+// перед её показом и показывать ленты по очереди, без параллельного RMT.
+// Цену обеих развёрток против времени провода меряет test/host/bench_expand
+
+// Яркость кометы на расстоянии k от головы: то же, что fadeToBlackBy
+// на каждом шаге, но считается при компиляции. Таблица общая для
+// шарика и кометы демо
+#define TRAIL_MAX (DEMO_STYLE == DEMO_COMET && DEMO_COMET_LEN > TRAIL_LEN ? DEMO_COMET_LEN : TRAIL_LEN)
+
+struct TrailLevels {
+  uint8_t at[TRAIL_MAX];
+
+  constexpr TrailLevels() : at() {
+    at[0] = 255;
+    for (int k = 1; k < TRAIL_MAX; k++)
+      at[k] = (at[k - 1] * (256 - TRAIL_FADE)) >> 8;
   }
+};
 
-  drawScores(s);
-  handleButtons(s, now);
+constexpr TrailLevels TRAIL_LEVELS;
 
-  if (now - g.lastMove >= SPEED_DELAY) {
-    g.lastMove = now;
-    g.ballPos += g.direction;
+unsigned long composeUs = 0;
+unsigned long showUs = 0;
 
-    if (g.ballPos < 0) {
-      g.scoreR += SCORE_STEP;
-      g.ballPos = NUM_LEDS / 2;
-      g.direction = DIR_RIGHT;
-    }
+void markDirty(int s, int lo, int hi) {
+  LaneRender &r = laneRender[s];
+  if (lo < 0) lo = 0;
+  if (hi > NUM_LEDS - 1) hi = NUM_LEDS - 1;
+  if (lo > hi) return;
+  if (lo < r.dirtyLo) r.dirtyLo = lo;
+  if (hi > r.dirtyHi) r.dirtyHi = hi;
+}
 
-    if (g.ballPos >= NUM_LEDS) {
-      g.scoreL += SCORE_STEP;
-      g.ballPos = NUM_LEDS / 2;
-      g.direction = DIR_LEFT;
-    }
-  }
+void markTrailDirty(int s) {
+  const LaneRender &r = laneRender[s];
+  int tail = r.ballPos - r.ballDir * (r.trailLen - 1);
+  markDirty(s, min(r.ballPos, tail), max(r.ballPos, tail));
+}
 
-  leds[s][g.ballPos] = COLOR_BALL;
+// Пустая дорожка: только фон
+void resetLaneRender(int s) {
+  laneRender[s] = LaneRender();
+  laneRender[s].ballPos = -NUM_LEDS;
+  laneRender[s].ballDir = DIR_RIGHT;   // с нулевым направлением lanePixel видит комету везде
+  laneRender[s].trailLen = TRAIL_LEN;
+  laneRender[s].dirtyLo = 0;
+  laneRender[s].dirtyHi = NUM_LEDS - 1;
+}
 
-  if (g.scoreL >= MAX_SCORE || g.scoreR >= MAX_SCORE) {
-    g.state = GAME_OVER;
+void resetAllLanes() {
+  for (int s = 0; s < NUM_STRIPS; s++)
+    resetLaneRender(s);
+}
+
+// Вся дорожка одним цветом поверх остальных слоёв
+void setLaneFill(int s, const CRGB &color) {
+  LaneRender &r = laneRender[s];
+  if (r.filled && r.fill == color) return;
+  r.filled = true;
+  r.fill = color;
+  markDirty(s, 0, NUM_LEDS - 1);
+}
+
+// Комета демо на пустой дорожке: слой шарика с длиной DEMO_COMET_LEN.
+// На развороте хвост сразу переходит за голову — прежний fadeToBlackBy
+// гасил его на месте
+void setLaneComet(int s, int pos, int dir) {
+  LaneRender &r = laneRender[s];
+  if (r.filled || r.barL || r.barR || r.trailLen != DEMO_COMET_LEN) {
+    resetLaneRender(s);
+    r.trailLen = DEMO_COMET_LEN;
   }
+  if (r.ballPos == pos && r.ballDir == dir) return;
+  markTrailDirty(s);
+  r.ballPos = pos;
+  r.ballDir = dir;
+  markTrailDirty(s);
 }
 
+// Меняет длину полосы; на экран попадает только разница.
+// true — полоса выросла
+bool resizeBar(int s, int side, int &drawn, int target) {
+  if (target > BAR_MAX) target = BAR_MAX;
+  if (target == drawn) return false;
 
-/* ================= CHECK GAME OVER BY COLOR ================= */
+  int lo = min(drawn, target);
+  int hi = max(drawn, target) - 1;
+  if (side == 0) markDirty(s, lo, hi);
+  else markDirty(s, NUM_LEDS - 1 - hi, NUM_LEDS - 1 - lo);
 
-bool checkThreeStripsSameColor(CRGB &color) {
-  int leftCount = 0;
-  int rightCount = 0;
+  bool grew = target > drawn;
+  drawn = target;
+  return grew;
+}
 
-  for (int s = 0; s < NUM_STRIPS; s++) {
-    if (game[s].scoreL >= MAX_SCORE) leftCount++;
-    if (game[s].scoreR >= MAX_SCORE) rightCount++;
+void setBars(int s, int left, int right) {
+  LaneRender &r = laneRender[s];
+  resizeBar(s, 0, r.barL, left);
+  resizeBar(s, 1, r.barR, right);
+}
+
+// Отрезок [from, to) полосы стороны side, считая от её края
+void markBarDirty(int s, int side, int from, int to) {
+  if (side == 0) markDirty(s, from, to - 1);
+  else markDirty(s, NUM_LEDS - to, NUM_LEDS - 1 - from);
+}
+
+void scoreEffect(int s, int side, int drawn, uint8_t slot, uint8_t &pulse) {
+  // Прошлый сегмент не допульсировал: он остался бы притушенным
+  if (pulse) markBarDirty(s, side, 0, drawn);
+  pulse = BAR_PULSE_FRAMES;
+#if FLASH_LEVEL > 0
+  laneRender[s].flashSlot = slot;
+  laneRender[s].flash = FLASH_LEVEL;
+#endif
+}
+
+// Пульсация последнего сегмента: не больше scoreStep пикселей за кадр
+void animateBar(int s, int side, int drawn, uint8_t &pulse) {
+  if (!pulse) return;
+  pulse--;
+
+  markBarDirty(s, side, max(0, drawn - rules.scoreStep), drawn);
+}
+
+void drawScores(int s) {
+  LaneRender &r = laneRender[s];
+  if (resizeBar(s, 0, r.barL, game[s].scoreL)) scoreEffect(s, 0, r.barL, PAL_LEFT, r.pulseL);
+  if (resizeBar(s, 1, r.barR, game[s].scoreR)) scoreEffect(s, 1, r.barR, PAL_RIGHT, r.pulseR);
+  animateBar(s, 0, r.barL, r.pulseL);
+  animateBar(s, 1, r.barR, r.pulseR);
+}
+
+void drawBall(int s) {
+  LaneRender &r = laneRender[s];
+  const StripGame &g = game[s];
+  if (r.ballPos == g.ballPos && r.ballDir == g.direction) return;
+
+  markTrailDirty(s);
+  r.ballPos = g.ballPos;
+  r.ballDir = g.direction;
+  markTrailDirty(s);
+}
+
+void drawObjects(int s) {
+  ObjectPool &p = pools[s];
+  for (int k = 0; k < p.count; k++) {
+    LaneObject &o = p.obj[k];
+    if (o.shownPos == o.pos) continue;
+    markDirty(s, o.shownPos, o.shownPos);
+    markDirty(s, o.pos, o.pos);
+    o.shownPos = o.pos;
   }
+}
 
-  if (leftCount >= 3) {
-    color = COLOR_LEFT;
-    return true;
+void drawEffects(int s) {
+  LaneRender &r = laneRender[s];
+  if (!r.flash) return;
+  markDirty(s, 0, NUM_LEDS - 1);
+  r.flash = qsub8(r.flash, FLASH_DECAY);
+}
+
+uint8_t pulseLevel(uint8_t pulse) {
+#if BAR_PULSE_FRAMES > 0
+  return pulse ? 255 - sin8(pulse * 128 / BAR_PULSE_FRAMES) / 2 : 255;
+#else
+  return 255;
+#endif
+}
+
+// Все слои в позиции i
+CRGB lanePixel(int s, int i) {
+  const LaneRender &r = laneRender[s];
+  const CRGB *pal = laneColors[s];
+  const int rightStart = NUM_LEDS - r.barR;
+
+  CRGB c = pal[PAL_BG];
+  bool inScore = true;
+
+  if (i < r.barL) {
+    c = pal[PAL_LEFT];
+    uint8_t k = BAR_LEVELS.at[i];
+    if (r.pulseL && i >= r.barL - rules.scoreStep) k = scale8(k, pulseLevel(r.pulseL));
+    if (k != 255) c.nscale8_video(k);
+  } else if (i >= rightStart) {
+    c = pal[PAL_RIGHT];
+    int d = NUM_LEDS - 1 - i;
+    uint8_t k = BAR_LEVELS.at[d];
+    if (r.pulseR && i < rightStart + rules.scoreStep) k = scale8(k, pulseLevel(r.pulseR));
+    if (k != 255) c.nscale8_video(k);
+  } else {
+    inScore = false;
   }
 
-  if (rightCount >= 3) {
-    color = COLOR_RIGHT;
-    return true;
+  unsigned k = (r.ballPos - i) * r.ballDir;
+  if (k < r.trailLen) {
+    uint8_t level = inScore ? scale8(TRAIL_LEVELS.at[k], BALL_OVER_SCORE) : TRAIL_LEVELS.at[k];
+    c += CRGB(pal[PAL_BALL]).nscale8_video(level);
   }
 
-  return false;
+  const ObjectPool &p = pools[s];
+  for (int n = 0; n < p.count; n++) {
+    if (p.obj[n].pos != i) continue;
+    if (p.obj[n].kind == OBJ_OBSTACLE) c = pal[PAL_OBSTACLE];
+    else c += pal[PAL_BALL];
+  }
+
+  if (r.flash) c = blend(c, pal[r.flashSlot], r.flash);
+  return c;
 }
 
-/* ================= LOOP ================= */
+// Отрезок дорожки [lo, hi] одного цвета
+void fillRun(int s, int lo, int hi, const CRGB &color) {
+  if (lo > hi) return;
+#if LAYOUT_IDENTITY
+  fill_solid(&leds[s][lo], hi - lo + 1, color);
+#else
+  for (int i = lo; i <= hi; i++) px(s, i) = color;
+#endif
+}
 
-void loop() {
-  static unsigned long lastDemo = 0;
-  static unsigned long lastGame = 0;
-  unsigned long now = millis();
+void composeLane(int s) {
+  LaneRender &r = laneRender[s];
+  if (r.dirtyLo > r.dirtyHi) return;
 
-  FastLED.clear();
+  const int lo = r.dirtyLo;
+  const int hi = r.dirtyHi;
+  r.dirtyLo = NUM_LEDS;
+  r.dirtyHi = -1;
+  pixelWrites += hi - lo + 1;
 
-  switch (globalState) {
-    case G_DEMO:
-      if (now - lastDemo >= DEMO_DELAY) {
-        demoAnimation();
-        lastDemo = now;
-        FastLED.show();
-      }
-      break;
+  if (r.filled) {
+    fillRun(s, lo, hi, r.fill);
+    return;
+  }
 
-    case G_START_FILL:
-      startFillAnimation();
-      FastLED.show();
-      break;
+  // Если нет градиента, пульсации и вспышки, фон и полосы — сплошные
+  // отрезки, а попиксельно считается только комета
+  if (!BAR_GRADIENT && !r.pulseL && !r.pulseR && !r.flash) {
+    const CRGB *pal = laneColors[s];
+    const int rightStart = NUM_LEDS - r.barR;
+    fillRun(s, lo, min(hi, r.barL - 1), pal[PAL_LEFT]);
+    fillRun(s, max(lo, r.barL), min(hi, rightStart - 1), pal[PAL_BG]);
+    fillRun(s, max(lo, rightStart), hi, pal[PAL_RIGHT]);
+
+    for (int k = 0; k < r.trailLen; k++) {
+      int i = r.ballPos - r.ballDir * k;
+      if (i >= lo && i <= hi) px(s, i) = lanePixel(s, i);
+    }
+    const ObjectPool &p = pools[s];
+    for (int k = 0; k < p.count; k++) {
+      int i = p.obj[k].pos;
+      if (i >= lo && i <= hi) px(s, i) = lanePixel(s, i);
+    }
+    return;
+  }
 
-    case G_PLAYING:
-      if (now - lastGame >= GAME_DELAY) {
-        for (int s = 0; s < NUM_STRIPS; s++)
-          updateStrip(s, now);
-        lastGame = now;
-
-        // Проверяем три ленты одного цвета
-        if (checkThreeStripsSameColor(gameOverColor)) {
-          blinkCount = 0;
-          blinkState = false;
-          lastBlink = now;
-          globalState = G_GAME_OVER_ANIM;
-        }
+  for (int i = lo; i <= hi; i++) px(s, i) = lanePixel(s, i);
+}
 
-        FastLED.show();
-      }
-      break;
+// Инкрементальная компоновка обязана дать то же, что lanePixel() по
+// всей дорожке. Быстрые пути, которые округляют иначе, укладываются в
+// FRAME_TOLERANCE на канал; всё, что больше, печатается как расхождение.
+// Это побайтовая сверка leds[], не сравнение по свету: дизеринг FastLED
+// добавляется при передаче, после leds[], и здесь не виден
+uint16_t verifyFaults = 0;
+
+void verifyLane(int s) {
+#if FRAME_VERIFY
+  const LaneRender &r = laneRender[s];
+  for (int i = 0; i < NUM_LEDS; i++) {
+    CRGB want = r.filled ? r.fill : lanePixel(s, i);
+    const CRGB &got = px(s, i);
+    int d = max(max(abs(got.r - want.r), abs(got.g - want.g)), abs(got.b - want.b));
+    if (d <= FRAME_TOLERANCE) continue;
+    verifyFaults++;
+    Serial.print("FV: lane ");
+    Serial.print(s);
+    Serial.print(" pixel ");
+    Serial.print(i);
+    Serial.print(" off by ");
+    Serial.println(d);
+    return;
+  }
+#endif
+}
 
-    case G_GAME_OVER_ANIM: {
-      const unsigned long blinkDelay = 300; // мс между миганиями
-      if (now - lastBlink >= blinkDelay) {
-        lastBlink = now;
-        blinkState = !blinkState;
-        blinkCount++;
+void composeFrame() {
+  unsigned long t = micros();
+  for (int s = 0; s < NUM_STRIPS; s++)
+    composeLane(s);
+  composeUs += micros() - t;
+  for (int s = 0; s < NUM_STRIPS; s++)
+    verifyLane(s);
+  captureFrame();
+  hashFrame();
+}
 
-        for (int s = 0; s < NUM_STRIPS; s++) {
-          fill_solid(leds[s], NUM_LEDS, blinkState ? gameOverColor : CRGB::Black);
-        }
+// Кадр вне игры (демо, заполнение, мигание)
+void showAll() {
+  composeFrame();
+  LED_OUTPUT::show();
+}
 
-        FastLED.show();
+void reportRenderStats(unsigned long now) {
+#if RENDER_STATS
+  static unsigned long lastReport = 0;
+  static uint32_t frames = 0;
+  frames++;
+  if (now - lastReport < 5000) return;
+
+  Serial.print("RENDER: ");
+  Serial.print(pixelWrites / frames);
+  Serial.print(" px/frame, compose ");
+  Serial.print(composeUs / frames);
+  Serial.print(" us, show ");
+  Serial.print(showUs / frames);
+  Serial.print(" us, hash ");
+  Serial.print(fh.us / frames);
+  Serial.println(" us");
+  lastReport = now;
+  frames = 0;
+  pixelWrites = 0;
+  composeUs = 0;
+  showUs = 0;
+  fh.us = 0;
+#endif
+}
 
-        if (blinkCount >= 10) { // 5 миганий (10 переключений)
-          globalState = G_DEMO;
-          fillPos = 0;
-          for (int s = 0; s < NUM_STRIPS; s++) {
-            game[s].state = PLAYING;
-            game[s].scoreL = 0;
-            game[s].scoreR = 0;
-          }
-        }
-      }
-    } break;
+/* ================= SCENARIO ================= */
+
+// Сценарий — нажатия по времени от старта и ожидаемые состояния автомата.
+// С SCENARIO 1 кнопки читаются из него, пины не опрашиваются; итог
+// печатается в Serial ("SCN: ok" или номер первого несовпавшего шага).
+// Это дымовая проверка на плате; сценарии с узорами дорожек и золотыми
+// кадрами идут на ПК: test/host/run_scenarios и test/host/scenarios/*.scn
+enum ScenarioOp : uint8_t { SC_DOWN, SC_UP, SC_EXPECT, SC_END };
+
+struct ScenarioStep {
+  uint32_t atMs;
+  uint8_t  op;
+  uint8_t  lane;
+  uint8_t  arg;   // 'L'/'R' для нажатий, GlobalState для SC_EXPECT
+};
+
+#define SC_PRESS(ms, lane, side) {ms, SC_DOWN, lane, side}, {(ms) + 60, SC_UP, lane, side}
+#define SC_HOLD(ms, lane, side)  {ms, SC_DOWN, lane, side}
+#define SC_LIFT(ms, lane, side)  {ms, SC_UP, lane, side}
+#define SC_STATE(ms, st)         {ms, SC_EXPECT, 0, st}
+
+#if SCENARIO
+// Старт, матч без отбиваний, кнопка зажата через конец матча —
+// автомат должен вернуться в демо и не стартовать сам
+const ScenarioStep SCRIPT[] PROGMEM = {
+  SC_STATE(500, G_DEMO),
+  SC_PRESS(1000, 0, 'L'),
+  SC_STATE(1100, G_START_FILL),
+  SC_STATE(2500, G_PLAYING),
+  SC_HOLD(15000, 2, 'R'),
+  SC_STATE(25000, G_DEMO),
+  SC_LIFT(25100, 2, 'R'),
+  SC_STATE(26000, G_DEMO),
+  SC_PRESS(27000, 4, 'R'),
+  SC_STATE(27100, G_START_FILL),
+  {0, SC_END, 0, 0}
+};
+#endif
+
+struct ScenarioRun {
+  uint16_t step;
+  bool down[NUM_STRIPS][2];
+  bool failed;
+  bool done;
+} scn;
+
+void pollScenario() {
+#if SCENARIO
+  unsigned long now = millis();
+  while (!scn.done) {
+    const ScenarioStep *st = &SCRIPT[scn.step];
+    uint8_t op = pgm_read_byte(&st->op);
+    if (op == SC_END) {
+      scn.done = true;
+#if FRAME_HASH
+      Serial.print("SCN: frames ");
+      Serial.print(fh.frames);
+      Serial.print(" hash ");
+      printHash(fh.run);
+      Serial.println();
+      if (SCENARIO_HASH && fh.run != (uint64_t)SCENARIO_HASH) {
+        scn.failed = true;
+        Serial.println("SCN: frames differ from SCENARIO_HASH");
+      }
+#endif
+      Serial.println(scn.failed ? "SCN: fail" : "SCN: ok");
+      break;
+    }
+    if (pgm_read_dword(&st->atMs) > now) break;
+
+    uint8_t lane = pgm_read_byte(&st->lane);
+    uint8_t arg  = pgm_read_byte(&st->arg);
+    if (op == SC_EXPECT) {
+      if (globalState != arg) {
+        scn.failed = true;
+        Serial.print("SCN: step ");
+        Serial.print(scn.step);
+        Serial.print(" want ");
+        Serial.print(arg);
+        Serial.print(" got ");
+        Serial.println(globalState);
+      }
+    } else if (lane < NUM_STRIPS) {
+      scn.down[lane][arg == 'R'] = (op == SC_DOWN);
+    }
+    scn.step++;
+  }
+#endif
+}
+
+/* ================= ZONES ================= */
+
+template <class Mode>
+void updateZones(StripGame &g) {
+  g.zoneL = Mode::zoneShift(g.scoreL);
+  g.zoneR = NUM_LEDS - 1 - g.hitZone - Mode::zoneShift(g.scoreR);
+}
+
+// Очко стороне side (0 — левой) и сдвиг зон вслед за счётом
+template <class Mode>
+void scorePoint(StripGame &g, int side) {
+  if (side == 0) g.scoreL += rules.scoreStep;
+  else g.scoreR += rules.scoreStep;
+  updateZones<Mode>(g);
+}
+
+// Смещение от начала зоны, если pos в зоне, иначе -1. Одно беззнаковое
+// сравнение вместо двух ветвлений
+inline int zoneOffset(int pos, int zoneStart, int width) {
+  unsigned offset = pos - zoneStart;
+  return offset <= (unsigned)width ? (int)offset : -1;
+}
+
+/* ================= DIFFICULTY ================= */
+
+// Уровень дорожки подстраивается под её игроков. Каждое отбивание или
+// промах сдвигает скользящие средние доли промахов и длины серии
+// отбиваний — O(1) на событие, без истории. Внутри полосы
+// DIFF_MISS_LO..DIFF_MISS_HI уровень не меняется, после смены держится
+// DIFF_HOLD событий. Соседние уровни отличаются заметно (зона на клетку),
+// и когда игроку подходит что-то между ними, каждый разворот удваивает
+// выдержку — контроллер затихает вместо качелей.
+// Уровень 0 — профиль правил. Зона не бывает шире профиля: rulesValid
+// проверял непересечение зон и полос только для неё. Мяч делает столько
+// шагов за кадр, сколько speedDelay уложилось, поэтому каждый уровень
+// меняет скорость, а не только те, что пересекают GAME_DELAY
+struct LaneSkill {
+  uint16_t missQ8;    // доля промахов, 1/256, окно ~16 событий
+  uint16_t rallyQ4;   // средняя серия отбиваний до промаха, 1/16
+  uint8_t rally;      // текущая серия
+  uint16_t hold;      // событий до следующей возможной смены
+  uint8_t backoff;    // разворотов подряд, выдержка DIFF_HOLD << backoff
+  int8_t level;
+  int8_t lastStep;
+};
+
+LaneSkill skill[NUM_STRIPS];
+
+template <class Mode>
+void applyDifficulty(StripGame &g, int level) {
+  g.speedDelay = max(rules.speedDelay * (DIFF_SPEED_DIV - level) / DIFF_SPEED_DIV, 1UL);
+  int narrow = level > 0 ? level : 0;
+  g.hitZone = max(rules.hitZone - narrow, min(rules.hitZone, 1));
+  updateZones<Mode>(g);
+}
+
+// Новые игроки начинают с профиля
+void difficultyReset() {
+  for (int s = 0; s < NUM_STRIPS; s++) {
+    skill[s] = LaneSkill();
+    skill[s].missQ8 = (DIFF_MISS_LO + DIFF_MISS_HI) * 256 / 200;
+    skill[s].hold = DIFF_HOLD;
+  }
+}
+
+// Исход розыгрыша на дорожке s: отбил или пропустил
+template <class Mode>
+void difficultyEvent(int s, bool hit) {
+#if DIFFICULTY
+  LaneSkill &k = skill[s];
+  if (hit) {
+    k.missQ8 -= k.missQ8 >> 4;
+    if (k.rally < 255) k.rally++;
+  } else {
+    k.missQ8 += (256 - k.missQ8) >> 4;
+    k.rallyQ4 += ((int)k.rally * 16 - (int)k.rallyQ4) / 4;
+    k.rally = 0;
+  }
+  if (k.hold) {
+    k.hold--;
+    return;
+  }
+
+  int rallyQ4 = max((int)k.rallyQ4, k.rally * 16);   // идущая серия тоже считается
+  int level = k.level;
+  if (k.missQ8 < DIFF_MISS_LO * 256 / 100 && rallyQ4 >= DIFF_RALLY_HI * 16) level++;
+  else if (k.missQ8 > DIFF_MISS_HI * 256 / 100) level--;
+  level = constrain(level, DIFF_MIN_LEVEL, DIFF_MAX_LEVEL);
+  if (level == k.level) return;
+
+  int step = level - k.level;
+  if (step == -k.lastStep && k.backoff < DIFF_BACKOFF_MAX) k.backoff++;
+  else if (step == k.lastStep) k.backoff = 0;
+  k.lastStep = step;
+  k.level = level;
+  k.hold = DIFF_HOLD << k.backoff;
+  applyDifficulty<Mode>(game[s], level);
+#if DIFF_LOG
+  Serial.print("DIFF: lane ");
+  Serial.print(s);
+  Serial.print(" level ");
+  Serial.print(level);
+  Serial.print(" miss ");
+  Serial.print(k.missQ8 * 100 / 256);
+  Serial.print("% rally ");
+  Serial.println(k.rallyQ4 / 16);
+#endif
+#endif
+}
+
+/* ================= OBJECTS ================= */
+
+void forgetShownObject(int s, uint8_t id);
+
+void addObject(int s, ObjectKind kind, int pos, int dir, bool visitor) {
+  ObjectPool &p = pools[s];
+  if (p.count >= OBJ_POOL) return;
+
+  // Свободный номер: ни у кого из объектов дорожки его нет
+  uint8_t id = 0;
+  for (int k = 0; k < p.count; k++)
+    if (p.obj[k].id == id) {
+      id++;
+      k = -1;
+    }
+
+  LaneObject &o = p.obj[p.count++];
+  o.pos = pos;
+  o.shownPos = pos;
+  o.dir = dir;
+  o.kind = kind;
+  o.id = id;
+  o.hitAt = -1;
+  o.visitor = visitor;
+  forgetShownObject(s, id);
+  markDirty(s, pos, pos);
+}
+
+void removeObject(int s, int k) {
+  ObjectPool &p = pools[s];
+  markDirty(s, p.obj[k].shownPos, p.obj[k].shownPos);
+  p.obj[k] = p.obj[--p.count];
+}
+
+/* ----- шина между дорожками ----- */
+
+// Каждая дорожка пишет только в свой ящик, поэтому обновление дорожек
+// пачками или на другом ядре не требует блокировок. Доставка идёт после
+// всех дорожек по порядку отправителей, и результат кадра не зависит
+// от порядка обновления
+#define LANE_OUTBOX 4
+
+struct LaneEvent {
+  uint8_t to;
+  int16_t pos;
+  int8_t dir;
+};
+
+struct LaneOutbox {
+  LaneEvent ev[LANE_OUTBOX];
+  uint8_t count;
+};
+
+LaneOutbox outbox[NUM_STRIPS];
+
+// Порядок обновления дорожек в кадре, по умолчанию 0..NUM_STRIPS-1.
+// Кадр от него не зависит; тест хоста lane_order перебирает порядки
+uint8_t laneOrder[NUM_STRIPS];
+
+// Мяч, вылетевший влево, входит в дорожку s-1 с правого края, вправо — в s+1 с левого
+void postHandoff(int from, int exitDir) {
+  int to = from + exitDir;
+  if (to < 0 || to >= NUM_STRIPS) return;
+  LaneOutbox &b = outbox[from];
+  if (b.count >= LANE_OUTBOX) return;
+  LaneEvent &e = b.ev[b.count++];
+  e.to = to;
+  e.pos = exitDir == DIR_LEFT ? NUM_LEDS - 1 : 0;
+  e.dir = exitDir;
+}
+
+void deliverLaneEvents() {
+  for (int s = 0; s < NUM_STRIPS; s++) {
+    LaneOutbox &b = outbox[s];
+    for (int k = 0; k < b.count; k++) {
+      const LaneEvent &e = b.ev[k];
+      if (game[e.to].state == PLAYING) addObject(e.to, OBJ_BALL, e.pos, e.dir, true);
+    }
+    b.count = 0;
+  }
+}
+
+template <class Mode>
+void spawnObjects(int s) {
+  pools[s].count = 0;
+  pools[s].tick = 0;
+  for (int k = 0; k < Mode::EXTRA_BALLS; k++) {
+    int side = (k & 1) ? -1 : 1;
+    addObject(s, OBJ_BALL, NUM_LEDS / 2 + side * 7 * (k / 2 + 1), side, false);
+  }
+  for (int k = 0; k < Mode::OBSTACLES; k++)
+    addObject(s, OBJ_OBSTACLE, NUM_LEDS * (k + 1) / (Mode::OBSTACLES + 1), (k & 1) ? DIR_LEFT : DIR_RIGHT, false);
+}
+
+// Препятствия ходят между зонами отбивания и в зоны не заходят
+template <class Mode>
+void obstacleBounds(int s, int &lo, int &hi) {
+  lo = game[s].zoneL + game[s].hitZone + 1;
+  hi = game[s].zoneR - 1;
+}
+
+// Основной мяч отскакивает от препятствия, в которое шагнул бы
+bool obstacleAt(int s, int pos) {
+  const ObjectPool &p = pools[s];
+  for (int k = 0; k < p.count; k++)
+    if (p.obj[k].kind == OBJ_OBSTACLE && p.obj[k].pos == pos) return true;
+  return false;
+}
+
+// Пул держится отсортированным по pos. После шага сортировка вставками
+// переставляет единицы объектов; мяч и препятствие, поменявшиеся местами
+// или оказавшиеся в одной клетке, столкнулись. Мяч запоминает первое
+// препятствие на своём пути, встаёт перед ним со своей стороны и
+// отскакивает; если там другое препятствие — остаётся, где был после шага.
+// Стоимость линейна по числу объектов
+void sweepObjects(int s) {
+  if (OBJ_POOL < 2) return;   // сталкиваться нечему
+
+  ObjectPool &p = pools[s];
+  for (int k = 1; k < p.count; k++) {
+    LaneObject o = p.obj[k];
+    int j = k - 1;
+    while (j >= 0 && p.obj[j].pos > o.pos) {
+      if (p.obj[j].kind != o.kind) {
+        if (o.kind == OBJ_BALL) {
+          if (o.hitAt < 0) o.hitAt = p.obj[j].pos;
+        } else if (p.obj[j].hitAt < 0) {
+          p.obj[j].hitAt = o.pos;
+        }
+      }
+      p.obj[j + 1] = p.obj[j];
+      j--;
+    }
+    p.obj[j + 1] = o;
+  }
+
+  for (int k = 1; k < p.count; k++) {
+    LaneObject &a = p.obj[k - 1];
+    LaneObject &b = p.obj[k];
+    if (a.pos != b.pos || a.kind == b.kind) continue;
+    LaneObject &ball = a.kind == OBJ_BALL ? a : b;
+    if (ball.hitAt < 0) ball.hitAt = a.pos;
+  }
+
+  for (int k = 0; k < p.count; k++) {
+    LaneObject &o = p.obj[k];
+    if (o.hitAt < 0) continue;
+    int before = o.hitAt - o.dir;
+    if (!obstacleAt(s, before)) o.pos = before;
+    o.hitAt = -1;
+    o.dir = -o.dir;
+  }
+
+  // Отскок мог переставить мяч за соседа по пулу: порядок восстанавливается
+  // без поиска столкновений, иначе следующий шаг примет перестановку за
+  // пересечение и мяч будет прыгать через препятствие на месте
+  for (int k = 1; k < p.count; k++) {
+    LaneObject o = p.obj[k];
+    int j = k - 1;
+    for (; j >= 0 && p.obj[j].pos > o.pos; j--) p.obj[j + 1] = p.obj[j];
+    p.obj[j + 1] = o;
+  }
+}
+
+// Шаг объектов дорожки вместе с основным мячом. Возвращает, сколько
+// очков принесли мячи, вылетевшие за край
+template <class Mode>
+int stepObjects(int s) {
+  if (OBJ_POOL == 0) return 0;
+
+  ObjectPool &p = pools[s];
+  StripGame &g = game[s];
+  bool obstacleStep = ++p.tick >= OBSTACLE_PERIOD;
+  if (obstacleStep) p.tick = 0;
+
+  int lo, hi;
+  obstacleBounds<Mode>(s, lo, hi);
+  int points = 0;
+
+  for (int k = 0; k < p.count; k++) {
+    LaneObject &o = p.obj[k];
+    if (o.kind == OBJ_OBSTACLE) {
+      if (!obstacleStep) continue;
+      int next = o.pos + o.dir;
+      if (next < lo || next > hi || next == g.ballPos) o.dir = -o.dir;
+      next = o.pos + o.dir;
+      if (next >= lo && next <= hi && next != g.ballPos) o.pos = next;
+      continue;
+    }
+
+    o.pos += o.dir;
+    if (o.pos >= 0 && o.pos < NUM_LEDS) continue;
+
+    scorePoint<Mode>(g, o.pos < 0 ? 1 : 0);
+    points++;
+    if (Mode::VISITORS) postHandoff(s, o.dir);
+
+    if (o.visitor) {
+      removeObject(s, k--);
+      continue;
+    }
+    o.pos = NUM_LEDS / 2;
+    o.dir = -o.dir;
+  }
+
+  sweepObjects(s);
+  return points;
+}
+
+/* ================= INPUT ================= */
+
+// Все кнопки за один проход читаются в битовую маску: бит 2*s — левая
+// кнопка дорожки s, 2*s+1 — правая, 1 — нажата. Фронты нажатий ищутся
+// XOR с прошлой маской сразу по 32 кнопки, фронт запоминается со временем
+// и обрабатывается на ближайшем кадре игры
+#define BTN_BITS  (NUM_STRIPS * 2)
+#define BTN_WORDS ((BTN_BITS + 31) / 32)
+
+// Кнопки на своих пинах, активный LOW
+struct InGpio {
+  static constexpr bool DIRECT_PINS = true;   // пины годятся для прерываний и пробуждения
+
+  static void begin() {
+    for (int s = 0; s < NUM_STRIPS; s++) {
+      pinMode(BTN_L[s], INPUT_PULLUP);
+      pinMode(BTN_R[s], INPUT_PULLUP);
+    }
+  }
+
+  static void scan(uint32_t *mask) {
+    for (int s = 0; s < NUM_STRIPS; s++) {
+      int b = 2 * s;
+      mask[b >> 5] |= (uint32_t)!digitalRead(BTN_L[s]) << (b & 31);
+      mask[b >> 5] |= (uint32_t)!digitalRead(BTN_R[s]) << ((b + 1) & 31);
+    }
+  }
+};
+
+// Цепочка 74HC165 на SPI: одна защёлка и один пакет на все кнопки.
+// LSBFIRST — k-й выдвинутый бит становится битом k маски; входы
+// с подтяжкой к питанию, кнопка замыкает на землю
+struct InShift165 {
+  static constexpr bool DIRECT_PINS = false;
+  static constexpr int BYTES = (BTN_BITS + 7) / 8;
+
+  static void begin() {
+    pinMode(SHIFT_LOAD_PIN, OUTPUT);
+    digitalWrite(SHIFT_LOAD_PIN, HIGH);
+#if defined(ESP32)
+    SPI.begin(SHIFT_CLK_PIN, SHIFT_DATA_PIN, -1, -1);   // пины VSPI по умолчанию заняты лентой 18
+#else
+    SPI.begin();
+#endif
+  }
+
+  static void scan(uint32_t *mask) {
+    uint8_t buf[BYTES];
+    digitalWrite(SHIFT_LOAD_PIN, LOW);
+    digitalWrite(SHIFT_LOAD_PIN, HIGH);
+    SPI.beginTransaction(SPISettings(SHIFT_SPI_HZ, LSBFIRST, SPI_MODE0));
+    SPI.transfer(buf, BYTES);
+    SPI.endTransaction();
+    for (int k = 0; k < BYTES; k++)
+      mask[k >> 2] |= (uint32_t)(uint8_t)~buf[k] << (8 * (k & 3));
+  }
+};
+
+// MCP23017 на I2C, по 16 кнопок (8 дорожек) на расширитель с адресами
+// от MCP_ADDR подряд; порт A — младшие 8 бит, B — старшие. Оба порта
+// читаются одним запросом
+struct InMcp23017 {
+  static constexpr bool DIRECT_PINS = false;
+  static constexpr int CHIPS = (BTN_BITS + 15) / 16;
+  static_assert(CHIPS <= 8, "MCP23017: не больше 8 расширителей на шине");
+  static_assert(MCP_SDA_PIN != SOUND_PIN && MCP_SDA_PIN != HAPTIC_PIN &&
+                MCP_SCL_PIN != SOUND_PIN && MCP_SCL_PIN != HAPTIC_PIN,
+                "MCP_SDA_PIN/MCP_SCL_PIN: пины заняты звуком или вибромотором");
+
+  static void writeReg(uint8_t addr, uint8_t reg, uint8_t v) {
+    Wire.beginTransmission(addr);
+    Wire.write(reg);
+    Wire.write(v);
+    Wire.endTransmission();
+  }
+
+  static void begin() {
+#if defined(ESP32)
+    Wire.begin(MCP_SDA_PIN, MCP_SCL_PIN, MCP_I2C_HZ);
+#else
+    Wire.begin();
+    Wire.setClock(MCP_I2C_HZ);
+#endif
+    for (int c = 0; c < CHIPS; c++) {
+      writeReg(MCP_ADDR + c, 0x0C, 0xFF);   // GPPUA: подтяжка
+      writeReg(MCP_ADDR + c, 0x0D, 0xFF);   // GPPUB
+    }
+  }
+
+  static void scan(uint32_t *mask) {
+    for (int c = 0; c < CHIPS; c++) {
+      Wire.beginTransmission(MCP_ADDR + c);
+      Wire.write(0x12);                     // GPIOA, затем GPIOB
+      Wire.endTransmission(false);
+      if (Wire.requestFrom(MCP_ADDR + c, 2) != 2) continue;
+      uint32_t bits = (uint8_t)~Wire.read();
+      bits |= (uint32_t)(uint8_t)~Wire.read() << 8;
+      mask[c >> 1] |= bits << (16 * (c & 1));
+    }
+  }
+};
+
+struct ButtonLatch {
+  bool pressed;          // фронт ещё не обработан
+  unsigned long atUs;
+};
+
+ButtonLatch btnL[NUM_STRIPS];
+ButtonLatch btnR[NUM_STRIPS];
+uint32_t btnDown[BTN_WORDS];     // маска с прошлого опроса
+unsigned long lastInputMs = 0;   // когда последний раз была нажата любая кнопка
+
+void inputBegin() {
+  INPUT_SOURCE::begin();
+}
+
+void scanButtons(uint32_t *mask) {
+#if SCENARIO
+  for (int s = 0; s < NUM_STRIPS; s++) {
+    mask[(2 * s) >> 5] |= (uint32_t)scn.down[s][0] << ((2 * s) & 31);
+    mask[(2 * s + 1) >> 5] |= (uint32_t)scn.down[s][1] << ((2 * s + 1) & 31);
+  }
+#else
+  INPUT_SOURCE::scan(mask);
+#endif
+  if (BTN_BITS & 31) mask[BTN_WORDS - 1] &= (1UL << (BTN_BITS & 31)) - 1;
+}
+
+void pollInputs() {
+  uint32_t mask[BTN_WORDS] = {};
+  scanButtons(mask);
+  unsigned long nowUs = micros();
+  bool any = false;
+
+  for (int w = 0; w < BTN_WORDS; w++) {
+    uint32_t rise = (mask[w] ^ btnDown[w]) & mask[w];
+    btnDown[w] = mask[w];
+    any |= mask[w] != 0;
+
+    while (rise) {
+      int b = w * 32 + __builtin_ctz(rise);
+      rise &= rise - 1;
+      ButtonLatch &l = (b & 1) ? btnR[b >> 1] : btnL[b >> 1];
+      if (!l.pressed) {
+        l.pressed = true;
+        l.atUs = nowUs;
+      }
+    }
+  }
+  if (any) lastInputMs = millis();
+}
+
+bool inputPending() {
+  for (int s = 0; s < NUM_STRIPS; s++)
+    if (btnL[s].pressed || btnR[s].pressed) return true;
+  return false;
+}
+
+void clearInputs() {
+  for (int s = 0; s < NUM_STRIPS; s++) {
+    btnL[s].pressed = false;
+    btnR[s].pressed = false;
+  }
+}
+
+/* ================= LATENCY ================= */
+
+// Самопроверка: фронт BTN_L ловится прерыванием, реакция (смена
+// направления или сброс шарика) попадает в ближайший показанный кадр,
+// его конец передачи — момент, когда реакцию стало видно. Отчёт —
+// гистограмма по LAT_BUCKET_US. Light sleep в этом режиме выключен:
+// пробуждение по уровню перенастраивает те же пины
+#define LAT_BUCKET_US 2000
+#define LAT_BUCKETS   32
+#define LAT_DEBOUNCE_US 20000
+
+#if LATENCY_TEST
+volatile unsigned long edgeUs[NUM_STRIPS];
+unsigned long latPressUs[NUM_STRIPS];
+bool latPending[NUM_STRIPS];
+uint16_t latHist[LAT_BUCKETS];
+uint16_t latSamples = 0;
+unsigned long latMin = ~0UL;
+unsigned long latMax = 0;
+
+template <int S>
+void IRAM_ATTR onEdgeL() {
+  unsigned long now = micros();
+  if (now - edgeUs[S] > LAT_DEBOUNCE_US) edgeUs[S] = now;
+}
+
+template <int S>
+void attachEdges() {
+  attachInterrupt(digitalPinToInterrupt(BTN_L[S]), onEdgeL<S>, FALLING);
+  attachEdges<S + 1>();
+}
+
+template <>
+void attachEdges<NUM_STRIPS>() {}
+
+void latencyReport() {
+  Serial.print("LAT: n=");
+  Serial.print(latSamples);
+  Serial.print(" min=");
+  Serial.print(latMin);
+  Serial.print(" max=");
+  Serial.print(latMax);
+  Serial.println(" us");
+  for (int b = 0; b < LAT_BUCKETS; b++) {
+    if (!latHist[b]) continue;
+    Serial.print("LAT: ");
+    Serial.print(b * LAT_BUCKET_US / 1000);
+    Serial.print("-");
+    Serial.print((b + 1) * LAT_BUCKET_US / 1000);
+    Serial.print(" ms ");
+    Serial.println(latHist[b]);
+  }
+}
+#endif
+
+void latencyBegin() {
+#if LATENCY_TEST
+  if (INPUT_SOURCE::DIRECT_PINS) attachEdges<0>();
+#endif
+}
+
+// Нажатие BTN_L дало реакцию в этом кадре логики. Начало отсчёта —
+// фронт из прерывания, если он был незадолго до опроса
+void latencyArm(int s, unsigned long polledUs) {
+#if LATENCY_TEST
+  unsigned long edge = edgeUs[s];
+  bool recent = (long)(polledUs - edge) >= 0 && polledUs - edge < LAT_DEBOUNCE_US;
+  latPressUs[s] = recent ? edge : polledUs;
+  latPending[s] = true;
+#endif
+}
+
+void latencyShown(unsigned long visibleAtUs) {
+#if LATENCY_TEST
+  for (int s = 0; s < NUM_STRIPS; s++) {
+    if (!latPending[s]) continue;
+    latPending[s] = false;
+
+    unsigned long us = visibleAtUs - latPressUs[s];
+    latHist[min(us / LAT_BUCKET_US, (unsigned long)LAT_BUCKETS - 1)]++;
+    latMin = min(latMin, us);
+    latMax = max(latMax, us);
+    if (++latSamples % LATENCY_REPORT == 0) latencyReport();
+  }
+#endif
+}
+
+/* ================= TIMING ================= */
+
+// Что и когда стало видно на лентах. Нажатие оценивается по положению
+// шарика в последнем кадре, который игрок уже видел в момент нажатия.
+#define WIRE_US (CTRL_LEDS * LED_OUTPUT::WIRE_NS_PER_LED / 1000UL + 50UL)
+
+struct ShownFrame {
+  unsigned long visibleAtUs;
+  int16_t ballPos[NUM_STRIPS];
+};
+
+ShownFrame frameHistory[FRAME_HISTORY];
+uint8_t frameHead = 0;
+uint8_t frameCount = 0;
+
+// Где в тех же кадрах были нарисованы объекты, по их номеру; -1 — не был.
+// Без объектов в режиме — одна пустая запись
+struct ShownObjects {
+  int16_t pos[NUM_STRIPS][OBJ_POOL > 0 ? OBJ_POOL : 1];
+};
+
+ShownObjects shownObjects[OBJ_POOL > 0 ? FRAME_HISTORY : 1];
+
+// Новый объект с освободившимся номером не должен получить чужую историю
+void forgetShownObject(int s, uint8_t id) {
+  if (OBJ_POOL == 0) return;
+  for (ShownObjects &f : shownObjects) f.pos[s][id] = -1;
+}
+long displayLatencyUs = 0;   // от начала кадра до видимости, скользящее среднее
+
+void recordShownFrame(unsigned long frameStartUs, unsigned long showStartUs, unsigned long showEndUs) {
+  unsigned long showUs = showEndUs - showStartUs;
+  unsigned long visibleAt = showStartUs + max(showUs, WIRE_US) + DISPLAY_EXTRA_US;
+
+  frameHead = (frameHead + 1) % FRAME_HISTORY;
+  if (frameCount < FRAME_HISTORY) frameCount++;
+
+  ShownFrame &f = frameHistory[frameHead];
+  f.visibleAtUs = visibleAt;
+  for (int s = 0; s < NUM_STRIPS; s++)
+    f.ballPos[s] = laneRender[s].ballPos;
+
+  if (OBJ_POOL > 0) {
+    ShownObjects &o = shownObjects[frameHead];
+    for (int s = 0; s < NUM_STRIPS; s++) {
+      for (int16_t &pos : o.pos[s]) pos = -1;
+      for (int k = 0; k < pools[s].count; k++)
+        o.pos[s][pools[s].obj[k].id] = pools[s].obj[k].shownPos;
+    }
+  }
+
+  displayLatencyUs += ((long)(visibleAt - frameStartUs) - displayLatencyUs) / 8;
+  latencyShown(visibleAt);
+}
+
+// Последний кадр, уже видимый в момент atUs, или самый старый из истории
+int seenFrame(unsigned long atUs) {
+  int idx = frameHead;
+  for (int k = 0; k < frameCount; k++) {
+    if ((long)(atUs - frameHistory[idx].visibleAtUs) >= 0) break;
+    if (k == frameCount - 1) break;
+    idx = (idx + FRAME_HISTORY - 1) % FRAME_HISTORY;
+  }
+  return idx;
+}
+
+// Положение шарика, которое игрок видел в момент atUs
+int seenBallPos(int s, unsigned long atUs) {
+  if (frameCount == 0) return game[s].ballPos;
+  return frameHistory[seenFrame(atUs)].ballPos[s];
+}
+
+// То же для объекта дорожки; -1 — в том кадре его ещё не было
+int seenObjectPos(int s, const LaneObject &o, unsigned long atUs) {
+  if (frameCount == 0) return o.pos;
+  return shownObjects[seenFrame(atUs)].pos[s][o.id];
+}
+
+// offset — расстояние видимого шарика от края зоны со стороны игрока
+HitGrade judgeHit(const StripGame &g, int seen, bool leftSide) {
+  int offset = zoneOffset(seen, leftSide ? g.zoneL : g.zoneR, g.hitZone);
+  if (offset < 0) return HIT_MISS;
+
+  if (!leftSide) offset = g.hitZone - offset;
+  if (offset * 3 > g.hitZone * 2) return HIT_EARLY;
+  if (offset * 3 < g.hitZone) return HIT_LATE;
+  return HIT_PERFECT;
+}
+
+void logGrade(int s, HitGrade grade) {
+#if TIMING_LOG
+  static const char *const names[] = { "early", "perfect", "late", "miss" };
+  Serial.print("HIT ");
+  Serial.print(s);
+  Serial.print(' ');
+  Serial.print(names[grade]);
+  Serial.print(", latency ");
+  Serial.print(displayLatencyUs);
+  Serial.println(" us");
+#endif
+}
+
+/* ================= SUPERVISOR ================= */
+
+// Ступени деградации при систематическом превышении GAME_DELAY
+enum DegradeLevel {
+  DEG_NONE,
+  DEG_NO_DITHER,    // без дизеринга
+  DEG_HALF_FPS,     // show() через кадр, логика по-прежнему каждые GAME_DELAY
+  DEG_SKIP_STATIC   // не передаём ленты, которые не меняются (GAME_OVER)
+};
+
+// Пропуск лент экономит время, только если они передаются по очереди:
+// у OutClockless (PARALLEL_SHOW) лестница кончается на DEG_HALF_FPS, и
+// DEG_SKIP_STATIC достижим только с тактируемыми лентами
+constexpr DegradeLevel DEG_MAX = LED_OUTPUT::PARALLEL_SHOW ? DEG_HALF_FPS : DEG_SKIP_STATIC;
+
+struct Supervisor {
+  DegradeLevel level;
+  uint8_t overruns;
+  uint16_t fastFrames;
+  uint8_t frameCount;
+  bool staticShown[NUM_CONTROLLERS];
+};
+
+Supervisor sup;
+
+// Ошибка настройки watchdog. Serial в setup() ещё не запущен, строку
+// WDT: печатает bootTasks()
+int watchdogErr = 0;
+
+void watchdogBegin() {
+#if defined(ESP32)
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+  // IDF 5: reconfigure меняет уже запущенный ядром TWDT; если ядро
+  // собрано без него (ESP_ERR_INVALID_STATE) — запускаем сами
+  esp_task_wdt_config_t cfg = { WDT_TIMEOUT_S * 1000, 0, true };
+  esp_err_t err = esp_task_wdt_reconfigure(&cfg);
+  if (err == ESP_ERR_INVALID_STATE) err = esp_task_wdt_init(&cfg);
+#else
+  // IDF 4: init поверх запущенного TWDT сам меняет таймаут
+  esp_err_t err = esp_task_wdt_init(WDT_TIMEOUT_S, true);
+#endif
+  if (err == ESP_OK) err = esp_task_wdt_add(NULL);
+  watchdogErr = err;
+#endif
+}
+
+void reportWatchdog() {
+  if (watchdogErr == 0) return;
+  Serial.print("WDT: init error ");
+  Serial.println(watchdogErr);
+}
+
+void watchdogFeed() {
+#if defined(ESP32)
+  esp_task_wdt_reset();
+#endif
+}
+
+void applyDegradeLevel(DegradeLevel level, unsigned long frameUs) {
+  sup.level = level;
+  FastLED.setDither(level >= DEG_NO_DITHER ? DISABLE_DITHER : BINARY_DITHER);
+  for (int c = 0; c < NUM_CONTROLLERS; c++)
+    sup.staticShown[c] = false;
+
+  Serial.print("SUP: level ");
+  Serial.print((int)level);
+  Serial.print(", frame ");
+  Serial.print(frameUs);
+  Serial.println(" us");
+}
+
+// Вывод кадра игры с учётом текущей ступени деградации.
+// Возвращает false, если кадр не передавался.
+bool showFrame() {
+  if (sup.level >= DEG_HALF_FPS && (sup.frameCount++ & 1)) return false;
+
+  composeFrame();
+
+#if SLOW_SHOW_US > 0
+  delayMicroseconds(SLOW_SHOW_US);
+#endif
+
+  unsigned long t = micros();
+
+  if (sup.level < DEG_SKIP_STATIC) {
+    LED_OUTPUT::show();
+  } else {
+    for (int c = 0; c < NUM_CONTROLLERS; c++) {
+      bool isStatic = true;
+      for (int s = 0; s < NUM_STRIPS; s++)
+        if (laneUsesCtrl(s, c) && game[s].state != GAME_OVER) isStatic = false;
+
+      if (isStatic && sup.staticShown[c]) continue;
+      sup.staticShown[c] = isStatic;
+      LED_OUTPUT::showCtrl(c, FastLED.getBrightness());   // та же яркость, что у show()
+    }
+  }
+
+  showUs += micros() - t;
+  return true;
+}
+
+// Учёт времени кадра относительно дедлайна GAME_DELAY
+void superviseFrame(unsigned long frameUs, bool shown) {
+  if (!shown) return;
+
+  const unsigned long deadlineUs = GAME_DELAY * 1000UL;
+
+  if (frameUs > deadlineUs) {
+    sup.fastFrames = 0;
+    if (++sup.overruns >= OVERRUN_LIMIT) {
+      sup.overruns = 0;
+      if (sup.level < DEG_MAX)
+        applyDegradeLevel((DegradeLevel)(sup.level + 1), frameUs);
+    }
+    return;
+  }
+
+  sup.overruns = 0;
+
+  // Возвращаемся на ступень выше только с запасом по времени
+  if (frameUs < deadlineUs * 3 / 4 && ++sup.fastFrames >= RECOVER_LIMIT) {
+    sup.fastFrames = 0;
+    if (sup.level > DEG_NONE)
+      applyDegradeLevel((DegradeLevel)(sup.level - 1), frameUs);
+  }
+}
+
+/* ================= SOUND ================= */
+
+// Игра только кладёт событие в кольцевую очередь и никогда не ждёт:
+// при полной очереди событие отбрасывается и считается. Проигрыватель
+// (отдельная задача на ядре 0 у ESP32, иначе опрос из loop()) сам
+// ведёт ноты по millis() и не задерживает кадр. На ПК tone() пишется в
+// журнал и WAV, совпадение звука с кадрами проверяет test/host/test_sound_wav
+static_assert((SOUND_QUEUE & (SOUND_QUEUE - 1)) == 0, "SOUND_QUEUE должно быть степенью двойки");
+
+enum SoundCue : uint8_t { CUE_HIT, CUE_PERFECT, CUE_MISS, CUE_START, CUE_WIN, CUE_COUNT };
+
+struct SoundNote {
+  uint16_t freq;   // 0 — пауза
+  uint16_t ms;
+};
+
+const SoundNote NOTES_HIT[]     PROGMEM = { {880, 40} };
+const SoundNote NOTES_PERFECT[] PROGMEM = { {1320, 30}, {1760, 40} };
+const SoundNote NOTES_MISS[]    PROGMEM = { {220, 120} };
+const SoundNote NOTES_START[]   PROGMEM = { {523, 80}, {659, 80}, {784, 120} };
+const SoundNote NOTES_WIN[]     PROGMEM = { {784, 100}, {0, 40}, {784, 100}, {1047, 250} };
+
+struct CueDef {
+  const SoundNote *notes;
+  uint8_t count;
+  uint8_t hapticMs;
+};
+
+const CueDef CUES[CUE_COUNT] = {
+  { NOTES_HIT,     1, 25 },
+  { NOTES_PERFECT, 2, 40 },
+  { NOTES_MISS,    1, 80 },
+  { NOTES_START,   3, 0 },
+  { NOTES_WIN,     4, 200 }
+};
+
+struct SoundEvent {
+  SoundCue cue;
+  unsigned long atMs;
+};
+
+// Один писатель (loop) и один читатель (проигрыватель на другом ядре):
+// каждый двигает только свой индекс. Запись индекса — release, чтение
+// чужого — acquire: читатель видит событие целиком раньше нового
+// soundHead, а писатель не затирает ячейку, пока soundTail не ушёл с неё.
+// volatile этого не даёт: он не упорядочивает обычные записи в
+// soundQueue и не ставит барьеров между ядрами
+SoundEvent soundQueue[SOUND_QUEUE];
+std::atomic<uint8_t> soundHead(0);
+std::atomic<uint8_t> soundTail(0);
+uint16_t soundDropped = 0;
+
+void postSound(SoundCue cue) {
+#if SOUND
+  uint8_t head = soundHead.load(std::memory_order_relaxed);
+  uint8_t next = (head + 1) & (SOUND_QUEUE - 1);
+  if (next == soundTail.load(std::memory_order_acquire)) {
+    soundDropped++;
+    return;
+  }
+  soundQueue[head].cue = cue;
+  soundQueue[head].atMs = millis();
+  soundHead.store(next, std::memory_order_release);
+#endif
+}
+
+struct SoundPlayer {
+  const CueDef *cue;
+  uint8_t note;
+  unsigned long noteEnd;
+  unsigned long hapticEnd;
+  bool hapticOn;
+};
+
+SoundPlayer player;
+
+void startNote(unsigned long now) {
+  uint16_t freq = pgm_read_word(&player.cue->notes[player.note].freq);
+  uint16_t ms   = pgm_read_word(&player.cue->notes[player.note].ms);
+  if (freq) tone(SOUND_PIN, freq);
+  else noTone(SOUND_PIN);
+  player.noteEnd = now + ms;
+}
+
+// Один шаг проигрывателя; новый сигнал прерывает звучащий
+void soundTick(unsigned long now) {
+  uint8_t tail = soundTail.load(std::memory_order_relaxed);
+  while (tail != soundHead.load(std::memory_order_acquire)) {
+    SoundEvent ev = soundQueue[tail];
+    tail = (tail + 1) & (SOUND_QUEUE - 1);
+    soundTail.store(tail, std::memory_order_release);
+    if (now - ev.atMs > SOUND_STALE_MS) continue;
+
+    player.cue = &CUES[ev.cue];
+    player.note = 0;
+    startNote(now);
+    if (player.cue->hapticMs) {
+      digitalWrite(HAPTIC_PIN, HIGH);
+      player.hapticOn = true;
+      player.hapticEnd = now + player.cue->hapticMs;
+    }
+  }
+
+  if (player.hapticOn && (long)(now - player.hapticEnd) >= 0) {
+    digitalWrite(HAPTIC_PIN, LOW);
+    player.hapticOn = false;
+  }
+
+  if (!player.cue || (long)(now - player.noteEnd) < 0) return;
+  if (++player.note < player.cue->count) {
+    startNote(now);
+  } else {
+    noTone(SOUND_PIN);
+    player.cue = nullptr;
+  }
+}
+
+#if SOUND && defined(ESP32)
+void soundTask(void *) {
+  for (;;) {
+    soundTick(millis());
+    vTaskDelay(1);
+  }
+}
+#endif
+
+void soundBegin() {
+#if SOUND
+  pinMode(SOUND_PIN, OUTPUT);
+  pinMode(HAPTIC_PIN, OUTPUT);
+  digitalWrite(HAPTIC_PIN, LOW);
+#if defined(ESP32)
+  // loop() работает на ядре 1, проигрыватель — на ядре 0
+  xTaskCreatePinnedToCore(soundTask, "sound", 2048, nullptr, 1, nullptr, 0);
+#endif
+#endif
+}
+
+// Без второго ядра проигрыватель опрашивается из loop()
+void soundPoll() {
+#if SOUND && !defined(ESP32)
+  soundTick(millis());
+#endif
+}
+
+/* ================= POWER ================= */
+
+// Демо без нажатий дольше IDLE_AFTER_MS: реже кадры, ниже яркость,
+// между кадрами light sleep. Просыпаемся по таймеру следующего кадра
+// или по низкому уровню на любой кнопке; нажатие сразу снимает режим
+// и демо отвечает на том же проходе loop(), не дожидаясь периода
+struct PowerState {
+  bool idle;
+  unsigned long shownUs;      // конец последнего show() в демо
+  unsigned long windowStart;  // начало минуты учёта
+  uint32_t sleptUs;           // сна за текущую минуту
+};
+
+PowerState power;
+
+void powerBegin() {
+#if IDLE_SLEEP && !LATENCY_TEST && defined(ESP32)
+  if (!INPUT_SOURCE::DIRECT_PINS) return;   // у расширителей будим по таймеру кадра
+  for (int s = 0; s < NUM_STRIPS; s++) {
+    gpio_wakeup_enable((gpio_num_t)BTN_L[s], GPIO_INTR_LOW_LEVEL);
+    gpio_wakeup_enable((gpio_num_t)BTN_R[s], GPIO_INTR_LOW_LEVEL);
+  }
+  esp_sleep_enable_gpio_wakeup();
+#endif
+}
+
+void updateIdle(unsigned long now) {
+  // now прочитан в начале loop(), а pollInputs() мог записать lastInputMs
+  // позже: без знака разность стала бы огромной и плата уснула бы от нажатия
+  bool idle = (long)(now - lastInputMs) >= (long)IDLE_AFTER_MS;
+  if (idle == power.idle) return;
+  power.idle = idle;
+  FastLED.setBrightness(idle ? IDLE_BRIGHTNESS : BRIGHTNESS);
+  if (idle) difficultyReset();         // следующими подойдут другие игроки
+#if POWER_LOG
+  Serial.println(idle ? "PWR: idle" : "PWR: wake");
+#endif
+}
+
+unsigned long demoDelay() {
+  return power.idle ? IDLE_DEMO_DELAY : DEMO_DELAY;
+}
+
+// Спим до untilMs, если кадр уже ушёл в ленты; иначе возвращаемся
+// и ждём конца передачи на следующих проходах loop()
+void idleSleep(unsigned long untilMs) {
+#if IDLE_SLEEP && !LATENCY_TEST && defined(ESP32)
+  if (!power.idle || SHARD_ROLE != SHARD_SOLO) return;   // во сне теряются байты связи плат
+  unsigned long now = millis();
+  if ((long)(untilMs - now) <= 1) return;
+  if (micros() - power.shownUs < WIRE_US) return;
+
+  unsigned long t0 = micros();
+  esp_sleep_enable_timer_wakeup((uint64_t)(untilMs - now) * 1000);
+  esp_light_sleep_start();
+  power.sleptUs += micros() - t0;
+#endif
+}
+
+void reportPower(unsigned long now) {
+  if (now - power.windowStart < 60000UL) return;
+#if POWER_LOG
+  unsigned long windowUs = (now - power.windowStart) * 1000UL;
+  Serial.print("PWR: awake ");
+  Serial.print(100UL - power.sleptUs / (windowUs / 100UL));
+  Serial.print("% idle=");
+  Serial.println(power.idle);
+#endif
+  power.windowStart = now;
+  power.sleptUs = 0;
+}
+
+/* ================= SHARD ================= */
+
+// Несколько плат в одном шкафу. Ведущая ведёт автомат игры и считает
+// командную победу по всем дорожкам, ведомые играют только свои
+// NUM_STRIPS дорожек. Каждые GAME_DELAY ведущая рассылает тик: своё
+// время, состояние автомата и номер опрашиваемой ведомой; кадр игры на
+// всех платах начинается по тику. Отвечает только опрошенная ведомая,
+// поэтому на шине RS-485 передатчик всегда один.
+// Кадр: A7 тип нагрузка CRC-8(тип, нагрузка)
+static_assert(SHARD_ROLE != SHARD_SOLO || SHARD_COUNT == 1, "SHARD_COUNT > 1 требует SHARD_MASTER или SHARD_SLAVE");
+static_assert(SHARD_ROLE == SHARD_SOLO || SHARD_COUNT > 1, "в шкафу должно быть больше одной платы");
+static_assert(SHARD_ROLE != SHARD_SLAVE || (SHARD_ID > 0 && SHARD_ID < SHARD_COUNT), "SHARD_ID ведомой: 1..SHARD_COUNT-1");
+
+#define SHARD_UART      Serial2
+#define SHARD_SYNC      0xA7
+#define SHARD_TICK      'T'    // ведущая -> все: ms:u32 state winner poll
+#define SHARD_STATUS    'S'    // ведомая -> ведущая: shard state leftWins rightWins flags
+#define SHARD_FRAME_MAX 10
+#define SHARD_START_REQ 0x01   // на ведомой нажали кнопку в демо
+
+struct ShardReport {
+  uint8_t state;
+  uint8_t leftWins;
+  uint8_t rightWins;
+  uint8_t flags;
+};
+
+struct ShardLink {
+  uint8_t rx[SHARD_FRAME_MAX];
+  uint8_t rxLen;
+  bool tickDue;             // тик разослан (ведущая) или принят (ведомая)
+  // ведущая
+  unsigned long lastTick;
+  uint8_t poll;
+  ShardReport report[SHARD_COUNT];
+  uint8_t winner;           // 0 — левые, 1 — правые
+  // ведомая
+  bool synced;
+  unsigned long lastRxMs;
+  long offsetQ4;            // время ведущей минус своё, 1/16 мс
+  uint8_t masterState;
+  bool startRequest;
+};
+
+ShardLink shard;
+
+// Время игры. На ведомой — часы ведущей: сдвиг сглаживается по тикам,
+// и мячи всех плат идут в одной фазе, даже когда кварцы расходятся
+unsigned long gameNow() {
+#if SHARD_ROLE == SHARD_SLAVE
+  return millis() + shard.offsetQ4 / 16;
+#else
+  return millis();
+#endif
+}
+
+// Законченные дорожки этой платы
+void countLaneWins(int &left, int &right) {
+  for (int s = 0; s < NUM_STRIPS; s++) {
+    if (game[s].scoreL >= rules.maxScore) left++;
+    if (game[s].scoreR >= rules.maxScore) right++;
+  }
+}
+
+// Ведущая добавляет дорожки ведомых, которые сейчас в матче
+void shardWins(int &left, int &right) {
+#if SHARD_ROLE == SHARD_MASTER
+  for (int k = 1; k < SHARD_COUNT; k++) {
+    if (shard.report[k].state != G_PLAYING) continue;
+    left += shard.report[k].leftWins;
+    right += shard.report[k].rightWins;
+  }
+#endif
+}
+
+bool shardStartRequested() {
+#if SHARD_ROLE == SHARD_MASTER
+  for (int k = 1; k < SHARD_COUNT; k++)
+    if (shard.report[k].state == G_DEMO && (shard.report[k].flags & SHARD_START_REQ)) return true;
+#endif
+  return false;
+}
+
+// CRC-8, полином 0x07: в отличие от XOR ловит и кадр, собранный
+// из хвоста одного и начала другого после потерянного байта
+uint8_t shardCrc(const uint8_t *p, int len) {
+  uint8_t crc = 0;
+  for (int i = 0; i < len; i++) {
+    crc ^= p[i];
+    for (int b = 0; b < 8; b++) crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+  }
+  return crc;
+}
+
+void shardSend(uint8_t type, const uint8_t *payload, uint8_t len) {
+  uint8_t frame[SHARD_FRAME_MAX];
+  frame[0] = SHARD_SYNC;
+  frame[1] = type;
+  for (int i = 0; i < len; i++) frame[2 + i] = payload[i];
+  frame[2 + len] = shardCrc(frame + 1, len + 1);
+#if SHARD_DE_PIN >= 0
+  digitalWrite(SHARD_DE_PIN, HIGH);
+  SHARD_UART.write(frame, len + 3);
+  SHARD_UART.flush();                 // DE снимаем после последнего стоп-бита
+  digitalWrite(SHARD_DE_PIN, LOW);
+#else
+  SHARD_UART.write(frame, len + 3);
+#endif
+}
+
+int shardPayloadLen(uint8_t type) {
+  if (type == SHARD_TICK) return 7;
+  if (type == SHARD_STATUS) return 5;
+  return -1;
+}
+
+// f[0] — тип, дальше нагрузка
+void shardReceive(const uint8_t *f) {
+#if SHARD_ROLE == SHARD_SLAVE
+  if (f[0] != SHARD_TICK) return;   // ответы других ведомых на общей шине
+  unsigned long now = millis();
+  uint32_t masterMs = f[1] | (uint32_t)f[2] << 8 | (uint32_t)f[3] << 16 | (uint32_t)f[4] << 24;
+  long sampleQ4 = (long)(masterMs - now) * 16;
+  if (f[5] > G_GAME_OVER_ANIM || f[6] > 1) return;
+  if (!shard.synced || now - shard.lastRxMs >= SHARD_TIMEOUT_MS) {
+    shard.offsetQ4 = sampleQ4;
+  } else {
+    // Перезапуск ведущей тоже даёт скачок: тики отбрасываются, пока
+    // связь не сочтётся потерянной, и тогда сдвиг берётся заново
+    if (labs(sampleQ4 - shard.offsetQ4) > SHARD_SKEW_MAX_MS * 16L) return;
+    shard.offsetQ4 += (sampleQ4 - shard.offsetQ4) / 8;
+  }
+  shard.synced = true;
+  shard.lastRxMs = now;
+  shard.masterState = f[5];
+  shard.winner = f[6];
+  shard.tickDue = true;
+  if (shard.masterState != G_DEMO) shard.startRequest = false;
+  if (f[7] != SHARD_ID) return;
+
+  int left = 0, right = 0;
+  countLaneWins(left, right);
+  uint8_t p[5] = { SHARD_ID, (uint8_t)globalState, (uint8_t)left, (uint8_t)right,
+                   (uint8_t)(shard.startRequest ? SHARD_START_REQ : 0) };
+  shardSend(SHARD_STATUS, p, sizeof(p));
+#elif SHARD_ROLE == SHARD_MASTER
+  if (f[0] != SHARD_STATUS || f[1] == 0 || f[1] >= SHARD_COUNT || f[2] > G_GAME_OVER_ANIM) return;
+  ShardReport &r = shard.report[f[1]];
+  r.state = f[2];
+  r.leftWins = f[3];
+  r.rightWins = f[4];
+  r.flags = f[5];
+#endif
+}
+
+// Приём по байту: синхронизация по A7, длина по типу, кадр с неверной
+// суммой отбрасывается целиком
+void shardByte(uint8_t b) {
+  if (shard.rxLen == 0 && b != SHARD_SYNC) return;
+  shard.rx[shard.rxLen++] = b;
+  if (shard.rxLen < 2) return;
+  int len = shardPayloadLen(shard.rx[1]);
+  if (len < 0) {
+    shard.rxLen = 0;
+    return;
+  }
+  if (shard.rxLen < len + 3) return;
+  if (shardCrc(shard.rx + 1, len + 1) == shard.rx[len + 2]) shardReceive(shard.rx + 1);
+  shard.rxLen = 0;
+}
+
+void shardBegin() {
+#if SHARD_ROLE != SHARD_SOLO
+#if SHARD_DE_PIN >= 0
+  pinMode(SHARD_DE_PIN, OUTPUT);
+  digitalWrite(SHARD_DE_PIN, LOW);
+#endif
+#if defined(ESP32)
+  SHARD_UART.begin(SHARD_BAUD, SERIAL_8N1, SHARD_RX_PIN, SHARD_TX_PIN);
+#else
+  SHARD_UART.begin(SHARD_BAUD);
+#endif
+#endif
+}
+
+void shardPoll() {
+#if SHARD_ROLE != SHARD_SOLO
+  while (SHARD_UART.available()) shardByte(SHARD_UART.read());
+#endif
+#if SHARD_ROLE == SHARD_MASTER
+  unsigned long now = millis();
+  if (now - shard.lastTick < GAME_DELAY) return;
+  shard.lastTick = now;
+  shard.poll = shard.poll % (SHARD_COUNT - 1) + 1;
+  uint8_t p[7] = { (uint8_t)now, (uint8_t)(now >> 8), (uint8_t)(now >> 16), (uint8_t)(now >> 24),
+                   (uint8_t)globalState, shard.winner, shard.poll };
+  shardSend(SHARD_TICK, p, sizeof(p));
+  shard.tickDue = true;
+#endif
+}
+
+// Кадр игры: у одиночной платы — по своему таймеру, в шкафу — по тику
+// ведущей. Ведомая без связи дольше SHARD_TIMEOUT_MS доигрывает свои
+// дорожки по своим часам
+bool gameFrameDue(unsigned long now, unsigned long lastGame) {
+#if SHARD_ROLE != SHARD_SOLO
+  if (shard.tickDue) {
+    shard.tickDue = false;
+    return true;
+  }
+  if (SHARD_ROLE == SHARD_MASTER || millis() - shard.lastRxMs < SHARD_TIMEOUT_MS) return false;
+#endif
+  return now - lastGame >= GAME_DELAY;
+}
+
+/* ================= SETUP ================= */
+
+template <int C>
+void addControllers() {
+  LED_OUTPUT::add<C>();
+  addControllers<C + 1>();
+}
+
+template <>
+void addControllers<NUM_CONTROLLERS>() {}
+
+// Время запуска, мкс от старта программы
+struct BootTimes {
+  unsigned long firstFrameUs;   // чёрный кадр ушёл в ленты
+  unsigned long showUs;         // сколько шёл его показ: все ленты целиком
+  unsigned long inputUs;        // первый опрос кнопок
+  bool done;
+};
+
+BootTimes boot;
+Timeline bootTl;
+
+// Предел частоты кадров по измеренному показу первого кадра; рядом —
+// оценка передачи самой длинной ленты по WIRE_NS_PER_LED
+void reportOutput() {
+  unsigned long showUs = max(boot.showUs, 1UL);
+  Serial.print("OUT: ");
+  Serial.print(LED_OUTPUT::name());
+  Serial.print(" show ");
+  Serial.print(boot.showUs);
+  Serial.print(" us, max ");
+  Serial.print(1000000UL / showUs);
+  Serial.print(" fps (wire estimate ");
+  Serial.print(WIRE_US);
+  Serial.println(" us)");
+}
+
+// Критический путь — только то, без чего нельзя погасить ленты и
+// принять нажатие. Остальное доделывает bootTasks() из loop()
+void setup() {
+  for (int c = 0; c < NUM_CONTROLLERS; c++) LED_OUTPUT::quiet(c);
+  FastLED.setBrightness(BRIGHTNESS);
+  addControllers<0>();
+  unsigned long showStart = micros();
+  LED_OUTPUT::show();                 // leds[] в .bss — кадр уже чёрный
+  boot.firstFrameUs = micros();
+  boot.showUs = boot.firstFrameUs - showStart;
+
+  applyRules(DEFAULT_RULES);
+  difficultyReset();
+  inputBegin();
+  watchdogBegin();
+  shardBegin();
+  latencyBegin();
+  for (int s = 0; s < NUM_STRIPS; s++) laneOrder[s] = s;
+  resetAllLanes();
+}
+
+void reportBoot() {
+  Serial.print("BOOT: first frame ");
+  Serial.print(boot.firstFrameUs);
+  Serial.print(" us, input ");
+  Serial.print(boot.inputUs);
+  Serial.print(" us, ready ");
+  Serial.print(micros());
+  Serial.println(" us");
+}
+
+// Отложенный запуск: по шагу за проход loop(), между шагами демо уже
+// рисуется и нажатия принимаются. Шаги не вынесены в отдельную задачу:
+// правила и палитры читает тот же loop(), и гонки были бы дороже
+// нескольких миллисекунд
+bool bootTasks() {
+  if (boot.done) return false;
+  TL_BEGIN(bootTl);
+  boot.inputUs = micros();
+#if CAPTURE && defined(ESP32)
+  Serial.setTxBufferSize(2048);
+#endif
+  Serial.begin(115200);
+  TL_YIELD(bootTl);
+  loadRules();
+  TL_YIELD(bootTl);
+  soundBegin();
+  powerBegin();
+  TL_YIELD(bootTl);
+  reportPaletteRam();
+  reportOutput();
+  reportWatchdog();
+  reportBoot();
+  boot.done = true;
+  TL_END(bootTl);
+}
+
+/* ================= START FILL ================= */
+
+const unsigned long FILL_DELAY = 20;
+
+// Вход в заполнение: сценарий начинается заново,
+// первый шаг рисуется на ближайшем проходе loop()
+void beginStartFill() {
+  anim = Timeline();
+  for (int s = 0; s < NUM_STRIPS; s++) {
+    pools[s].count = 0;
+    outbox[s].count = 0;
+  }
+  for (int k = 0; k < SHARD_COUNT; k++) shard.report[k] = ShardReport();
+  applyPendingRules();
+  resetAllLanes();
+  postSound(CUE_START);
+  setGlobalState(G_START_FILL);
+}
+
+void startMatch() {
+  for (int s = 0; s < NUM_STRIPS; s++) {
+    game[s].state      = PLAYING;
+    game[s].ballPos    = NUM_LEDS / 2;
+    game[s].direction  = (s % 2 == 0) ? 1 : -1;
+    game[s].scoreL     = 0;
+    game[s].scoreR     = 0;
+    game[s].lastMove   = gameNow();
+    game[s].lastButton = 0;
+    applyDifficulty<GAME_MODE>(game[s], skill[s].level);
+    laneRender[s].needsReset = true;
+    spawnObjects<GAME_MODE>(s);
+  }
+  clearInputs();
+  frameCount = 0;
+  setGlobalState(G_PLAYING);
+}
+
+// Нажатие в демо: ведомая только просит ведущую начать матч
+void requestStart() {
+  if (SHARD_ROLE == SHARD_SLAVE) {
+    shard.startRequest = true;
+    clearInputs();
+  } else {
+    beginStartFill();
+  }
+}
+
+// Полосы растут от краёв к центру, на последнем шаге начинается матч
+bool startFillAnimation() {
+  TL_BEGIN(anim);
+  for (anim.i = 1; anim.i <= NUM_LEDS / 2; anim.i++) {
+    for (int s = 0; s < NUM_STRIPS; s++)
+      setBars(s, anim.i, anim.i);
+    if (anim.i == NUM_LEDS / 2) startMatch();
+    TL_FRAME(anim, FILL_DELAY);
+  }
+  TL_END(anim);
+}
+
+/* ================= GAME OVER ================= */
+
+const unsigned long BLINK_DELAY = 300;   // мс между миганиями
+const int BLINK_TOGGLES = 10;            // 5 миганий
+
+void beginGameOver() {
+  anim = Timeline();
+  postSound(CUE_WIN);
+  setGlobalState(G_GAME_OVER_ANIM);
+}
+
+void endMatch() {
+  setGlobalState(G_DEMO);
+  clearInputs();
+  for (int s = 0; s < NUM_STRIPS; s++) {
+    game[s].state = PLAYING;
+    game[s].scoreL = 0;
+    game[s].scoreR = 0;
+  }
+}
+
+// Законченная дорожка — цветом своего победителя
+void fillLaneWinner(int s) {
+  const StripGame &g = game[s];
+  if (g.scoreL >= rules.maxScore) setLaneFill(s, laneColor(s, PAL_LEFT));
+  else if (g.scoreR >= rules.maxScore) setLaneFill(s, laneColor(s, PAL_RIGHT));
+}
+
+// Все дорожки мигают цветом победителя, затем возврат в демо.
+// OVER_HOLD (прежние скетчи): дорожки держат цвет своего победителя,
+// столько же, сколько шло бы мигание; дорожка, закончившая матч,
+// заливается здесь. Прежние скетчи держали цвет до сброса платы
+bool gameOverAnimation() {
+  TL_BEGIN(anim);
+#if OVER_STYLE == OVER_HOLD
+  for (int s = 0; s < NUM_STRIPS; s++)
+    fillLaneWinner(s);
+  TL_FRAME(anim, BLINK_DELAY * (BLINK_TOGGLES + 1));
+  endMatch();
+#else
+  TL_WAIT(anim, BLINK_DELAY);
+  for (anim.i = 0; anim.i < BLINK_TOGGLES; anim.i++) {
+    for (int s = 0; s < NUM_STRIPS; s++)
+      setLaneFill(s, (anim.i & 1) ? CRGB(CRGB::Black) : gameOverColor);
+    if (anim.i == BLINK_TOGGLES - 1) endMatch();
+    TL_FRAME(anim, BLINK_DELAY);
+  }
+#endif
+  TL_END(anim);
+}
+
+/* ================= DEMO ================= */
+
+void demoAnimation() {
+  // Проверка кнопок: старт только по новому нажатию, кнопка,
+  // зажатая с конца прошлого матча, игру не запускает
+  for (int s = 0; s < NUM_STRIPS; s++) {
+    if (btnL[s].pressed || btnR[s].pressed) {
+      requestStart();
+      return;
+    }
+  }
+  if (shardStartRequested()) {
+    beginStartFill();
+    return;
+  }
+
+#if DEMO_STYLE == DEMO_COMET
+  // ===== Комета от края до края =====
+  static int pos = 0;
+  static int dir = 1;
+
+  for (int s = 0; s < NUM_STRIPS; s++)
+    setLaneComet(s, pos, dir);
+
+  pos += dir;
+  if (pos <= 0 || pos >= NUM_LEDS - 1) dir = -dir;
+#else
+  // ===== Плавное дыхание =====
+  static int step = 2;
+  static int dir = 1;
+  const int minB = 15;
+  const int maxB = 50;
+  const int stepsCount = 20;
+
+  uint8_t brightness = minB + (maxB - minB) * step / stepsCount;
+
+  for (int s = 0; s < NUM_STRIPS; s++) {
+    setLaneFill(s, CRGB(brightness, brightness, brightness));
+  }
+
+  step += dir;
+  if (step >= stepsCount) { step = stepsCount; dir = -1; }
+  if (step <= 0)          { step = 0;          dir = 1;  }
+#endif
+}
+
+/* ================= BUTTONS ================= */
+
+void postGradeSound(HitGrade grade) {
+  postSound(grade == HIT_PERFECT ? CUE_PERFECT : grade == HIT_MISS ? CUE_MISS : CUE_HIT);
+}
+
+// Если основной мяч не в зоне, отбивается дополнительный, летящий к игроку.
+// Как и основной, он оценивается там, где его видел игрок
+HitGrade hitExtraBall(int s, int newDir, unsigned long atUs) {
+  ObjectPool &p = pools[s];
+  for (int k = 0; k < p.count; k++) {
+    LaneObject &o = p.obj[k];
+    if (o.kind != OBJ_BALL || o.dir == newDir) continue;
+    HitGrade grade = judgeHit(game[s], seenObjectPos(s, o, atUs), newDir == DIR_RIGHT);
+    if (grade == HIT_MISS) continue;
+    o.dir = newDir;
+    return grade;
+  }
+  return HIT_MISS;
+}
+
+template <class Mode>
+void handleButtons(int s, unsigned long now) {
+  StripGame &g = game[s];
+
+  if (now - g.lastButton < BUTTON_LOCKOUT) {
+    btnL[s].pressed = false;
+    btnR[s].pressed = false;
+    return;
+  }
+
+  if (btnL[s].pressed) {
+    btnL[s].pressed = false;
+    g.lastButton = now;
+    latencyArm(s, btnL[s].atUs);
+    g.lastGrade = judgeHit(g, seenBallPos(s, btnL[s].atUs), true);
+    if (g.lastGrade == HIT_MISS && Mode::EXTRA_BALLS + Mode::VISITORS)
+      g.lastGrade = hitExtraBall(s, DIR_RIGHT, btnL[s].atUs);
+    else if (g.lastGrade != HIT_MISS)
+      g.direction = DIR_RIGHT;
+
+    if (g.lastGrade == HIT_MISS) {
+      scorePoint<Mode>(g, 1);
+      g.ballPos = NUM_LEDS / 2;
+      g.direction = DIR_RIGHT;
+    }
+    difficultyEvent<Mode>(s, g.lastGrade != HIT_MISS);
+    logGrade(s, g.lastGrade);
+    postGradeSound(g.lastGrade);
+  }
+
+  if (btnR[s].pressed) {
+    btnR[s].pressed = false;
+    g.lastButton = now;
+    g.lastGrade = judgeHit(g, seenBallPos(s, btnR[s].atUs), false);
+    if (g.lastGrade == HIT_MISS && Mode::EXTRA_BALLS + Mode::VISITORS)
+      g.lastGrade = hitExtraBall(s, DIR_LEFT, btnR[s].atUs);
+    else if (g.lastGrade != HIT_MISS)
+      g.direction = DIR_LEFT;
+
+    if (g.lastGrade == HIT_MISS) {
+      scorePoint<Mode>(g, 0);
+      g.ballPos = NUM_LEDS / 2;
+      g.direction = DIR_LEFT;
+    }
+    difficultyEvent<Mode>(s, g.lastGrade != HIT_MISS);
+    logGrade(s, g.lastGrade);
+    postGradeSound(g.lastGrade);
+  }
+}
+
+/* ================= PLAY GAME ================= */
+
+#define BALL_STEPS_MAX 4   // шагов мяча за кадр; отставание больше (скачок часов) не догоняется
+
+template <class Mode>
+void stepBall(int s) {
+  StripGame &g = game[s];
+  if (Mode::OBSTACLES && obstacleAt(s, g.ballPos + g.direction)) g.direction = -g.direction;
+  else g.ballPos += g.direction;
+
+  if (g.ballPos < 0) {
+    if (Mode::VISITORS) postHandoff(s, DIR_LEFT);
+    postSound(CUE_MISS);
+    difficultyEvent<Mode>(s, false);
+    scorePoint<Mode>(g, 1);
+    g.ballPos = NUM_LEDS / 2;
+    g.direction = DIR_RIGHT;
+  }
+
+  if (g.ballPos >= NUM_LEDS) {
+    if (Mode::VISITORS) postHandoff(s, DIR_RIGHT);
+    postSound(CUE_MISS);
+    difficultyEvent<Mode>(s, false);
+    scorePoint<Mode>(g, 0);
+    g.ballPos = NUM_LEDS / 2;
+    g.direction = DIR_LEFT;
+  }
+
+  if (stepObjects<Mode>(s)) postSound(CUE_MISS);
+}
+
+template <class Mode>
+void updateStrip(int s, unsigned long now) {
+  StripGame &g = game[s];
+
+  LaneRender &r = laneRender[s];
+  if (r.needsReset) resetLaneRender(s);
+
+  if (g.state == GAME_OVER) {
+    fillLaneWinner(s);
+    return;
+  }
+
+  handleButtons<Mode>(s, now);
+
+  // Шаги отсчитываются от прошлого шага, а не от кадра: speedDelay,
+  // не кратный GAME_DELAY, даёт свою среднюю скорость. Разность знаковая:
+  // часы ведомой при подстройке к ведущей могут чуть отступить назад
+  for (int n = 0; (long)(now - g.lastMove) >= (long)g.speedDelay; n++) {
+    if (n == BALL_STEPS_MAX) {
+      g.lastMove = now;
+      break;
+    }
+    g.lastMove += g.speedDelay;
+    stepBall<Mode>(s);
+    if (g.scoreL >= rules.maxScore || g.scoreR >= rules.maxScore) break;
+  }
+
+  drawScores(s);
+  drawBall(s);
+  drawObjects(s);
+  drawEffects(s);
+
+  if (g.scoreL >= rules.maxScore || g.scoreR >= rules.maxScore) {
+    g.state = GAME_OVER;
+  }
+}
+
+
+/* ================= INVARIANTS ================= */
+
+// Состояние дорожки после кадра: мяч внутри ленты и летит, зоны
+// отбивания внутри ленты и не заходят друг на друга (их двигают счёт,
+// hitZone из профиля правил и подстройка сложности). Длину полос
+// проверять незачем: её ограничивает resizeBar. Нарушение печатается и
+// исправляется до следующего кадра: мяч возвращается в центр, зоны
+// сжимаются к своим половинам
+uint16_t invariantFaults = 0;
+
+void checkInvariants(int s) {
+#if INVARIANT_CHECK
+  StripGame &g = game[s];
+  bool ballOk = g.ballPos >= 0 && g.ballPos < NUM_LEDS &&
+                (g.direction == DIR_RIGHT || g.direction == DIR_LEFT);
+  for (int k = 0; k < pools[s].count; k++)
+    if (pools[s].obj[k].pos < 0 || pools[s].obj[k].pos >= NUM_LEDS) ballOk = false;
+  bool zonesOk = g.state != PLAYING ||
+                 (g.zoneL >= 0 && g.zoneL + g.hitZone < g.zoneR && g.zoneR + g.hitZone <= NUM_LEDS - 1);
+  if (ballOk && zonesOk) return;
+
+  invariantFaults++;
+  Serial.print("INV: lane ");
+  Serial.print(s);
+  Serial.print(" ball ");
+  Serial.print(g.ballPos);
+  Serial.print(" zones ");
+  Serial.print(g.zoneL);
+  Serial.print("/");
+  Serial.print(g.zoneR);
+  Serial.print("+");
+  Serial.println(g.hitZone);
+
+  if (!ballOk) {
+    g.ballPos = NUM_LEDS / 2;
+    g.direction = (s % 2 == 0) ? DIR_RIGHT : DIR_LEFT;
+    spawnObjects<GAME_MODE>(s);
+  }
+  if (!zonesOk) {
+    g.hitZone = constrain(g.hitZone, 0, NUM_LEDS / 4);
+    g.zoneL = constrain(g.zoneL, 0, NUM_LEDS / 2 - 1 - g.hitZone);
+    g.zoneR = constrain(g.zoneR, NUM_LEDS / 2, NUM_LEDS - 1 - g.hitZone);
+  }
+#endif
+}
+
+/* ================= CHECK GAME OVER BY COLOR ================= */
+
+// Цвет победителя матча, когда его признаёт режим
+template <class Mode>
+bool checkMatchOver(CRGB &color) {
+  // При нечётном числе дорожек большинство есть всегда, когда закончены
+  // все дорожки, поэтому автомат не может застрять в G_PLAYING
+  static_assert(!Mode::MAJORITY || TOTAL_LANES % 2 == 1,
+                "матч по большинству: NUM_STRIPS * SHARD_COUNT должно быть нечётным");
+  int leftCount = 0;
+  int rightCount = 0;
+
+  countLaneWins(leftCount, rightCount);
+  shardWins(leftCount, rightCount);
+
+  if (!Mode::matchOver(leftCount, rightCount)) return false;
+
+  shard.winner = leftCount >= rightCount ? 0 : 1;
+  color = shard.winner == 0 ? rules.colorLeft : rules.colorRight;
+  return true;
+}
+
+/* ================= SHARD SYNC ================= */
+
+// Ведомая повторяет переходы автомата ведущей. Заполнение и мигание
+// идут по своим часам и заканчиваются сами почти одновременно с
+// ведущей, поэтому догоняем только по смене её состояния: отставшая
+// или включённая посреди матча плата переходит сразу
+void followMaster() {
+#if SHARD_ROLE == SHARD_SLAVE
+  static uint8_t applied = G_DEMO;
+  if (!shard.synced || shard.masterState == applied) return;
+  applied = shard.masterState;
+  if (globalState == applied) return;
+
+  switch (applied) {
+    case G_DEMO:
+      endMatch();
+      break;
+    case G_START_FILL:
+      beginStartFill();
+      break;
+    case G_PLAYING:
+      startMatch();
+      break;
+    case G_GAME_OVER_ANIM:
+      gameOverColor = shard.winner == 0 ? rules.colorLeft : rules.colorRight;
+      beginGameOver();
+      break;
+  }
+#endif
+}
+
+/* ================= LOOP ================= */
+
+void loop() {
+  static unsigned long lastDemo = 0;
+  static unsigned long lastGame = 0;
+  unsigned long now = millis();
+
+  watchdogFeed();
+  pollSerialRules();
+  pollScenario();
+  pollInputs();
+  bootTasks();
+  shardPoll();
+  followMaster();
+  soundPoll();
+  reportPower(now);
+
+  switch (globalState) {
+    case G_DEMO:
+      updateIdle(now);
+      if (now - lastDemo >= demoDelay() || inputPending()) {
+        demoAnimation();
+        lastDemo = now;
+        showAll();
+        power.shownUs = micros();
+      } else {
+        idleSleep(lastDemo + demoDelay());
+      }
+      break;
+
+    case G_START_FILL:
+      if (startFillAnimation()) showAll();
+      break;
+
+    case G_PLAYING:
+      if (gameFrameDue(gameNow(), lastGame)) {
+        unsigned long frameStart = micros();
+        unsigned long t = gameNow();
+
+        for (int k = 0; k < NUM_STRIPS; k++) {
+          updateStrip<GAME_MODE>(laneOrder[k], t);
+          checkInvariants(laneOrder[k]);
+        }
+        deliverLaneEvents();
+        lastGame = t;
+
+        // Проверяем конец матча по правилам режима; в шкафу решает ведущая
+        if (SHARD_ROLE != SHARD_SLAVE && checkMatchOver<GAME_MODE>(gameOverColor)) beginGameOver();
+
+        unsigned long showStart = micros();
+        bool shown = showFrame();
+        if (shown) recordShownFrame(frameStart, showStart, micros());
+        superviseFrame(micros() - frameStart, shown);
+        reportRenderStats(now);
+      }
+      break;
+
+    case G_GAME_OVER_ANIM:
+      if (gameOverAnimation()) showAll();
+      break;
   }
 }
@@ -0,0 +1,62 @@
+// Записи пикселей за кадр игры. Прежний drawScores() перерисовывал
+// scoreL + scoreR пикселей каждой дорожки на каждом кадре; слой счёта
+// пишет только изменившиеся сегменты, а компоновщик — грязный диапазон.
+// Матч без отбиваний проходит от 0 до MAX_SCORE на всех дорожках;
+// на каждом показанном кадре игры сравниваются pixelWrites скетча и
+// то, что писал бы прежний путь (полосы плюс шарик со следом).
+// Вариант bench_bars_gradient — с BAR_GRADIENT и пульсацией сегмента.
+// Без санитайзеров (PLAIN):
+//   bench_bars
+#include SKETCH
+#include "host.h"
+
+using namespace host;
+
+namespace {
+
+struct Totals {
+  unsigned long frames = 0;
+  uint64_t writes = 0, repaint = 0;
+  uint32_t worst = 0, worstRepaint = 0;
+};
+
+Totals total;
+uint32_t writesBefore = 0;
+
+void onFrame() {
+  const uint32_t writes = pixelWrites - writesBefore;
+  writesBefore = pixelWrites;
+  if (globalState != G_PLAYING) return;
+
+  uint32_t repaint = 0;
+  for (int s = 0; s < NUM_STRIPS; s++)
+    if (game[s].state == PLAYING) repaint += game[s].scoreL + game[s].scoreR + TRAIL_LEN + 1;
+  total.frames++;
+  total.writes += writes;
+  total.repaint += repaint;
+  total.worst = max(total.worst, writes);
+  total.worstRepaint = max(total.worstRepaint, repaint);
+}
+
+}  // namespace
+
+int main() {
+  onShow = onFrame;
+  bootBoard();
+  press(0, 'L');
+  for (int k = 0; k < 5000 && globalState != G_PLAYING; k++) tick();
+  CHECK_EQ(globalState, G_PLAYING);
+  writesBefore = pixelWrites;
+  for (int k = 0; k < 300000 && globalState == G_PLAYING; k++) tick();
+  CHECK(globalState != G_PLAYING);
+
+  CHECK(total.frames > 0);
+  const double perFrame = (double)total.writes / max(1UL, total.frames);
+  const double repaintPerFrame = (double)total.repaint / max(1UL, total.frames);
+  printf("bench_bars: %d lanes, SCORE_STEP %d, MAX_SCORE %d, BAR_GRADIENT %d, %lu frames\n", NUM_STRIPS,
+         rules.scoreStep, rules.maxScore, BAR_GRADIENT, total.frames);
+  printf("  pixel writes per frame: layers %.1f (worst %u), repaint %.1f (worst %u)\n", perFrame, total.worst,
+         repaintPerFrame, total.worstRepaint);
+  CHECK(perFrame < repaintPerFrame);
+  return report("bench_bars");
+}
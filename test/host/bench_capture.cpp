@@ -0,0 +1,130 @@
+// Поток CAPTURE на 16 дорожках по 1000 светодиодов: успевает ли кодер за
+// CAPTURE_MIN_FPS кадрами в секунду. Буфер передачи большой, как у записи
+// в файл на хосте; UART платы такой поток не пропустит, и кадры уходили
+// бы частями (test_capture). Отдельного потока записи нет: кодер пишет
+// в буфер передачи и не ждёт, опустошает его драйвер UART (на хосте —
+// строка Serial.out). Сначала декодер по ходу матча держит ровно ленты,
+// затем меряется показ кадра — composeFrame() с кодером — на кадре игры,
+// где сдвинулись шарики всех дорожек, на полном (ключевом) кадре и на
+// худшем — шум, где каждый пиксель новый и идёт списком.
+// Числа хоста, не ESP32. Без санитайзеров (PLAIN):
+//   bench_capture [кадров, по умолчанию 300]
+#include SKETCH
+#include "host.h"
+#include "capture_decode.h"
+
+#include <chrono>
+
+using namespace host;
+
+namespace {
+
+constexpr double CAPTURE_MIN_FPS = 100;
+
+capture::Decoder dec;
+size_t fed = 0;
+int faults = 0;
+unsigned long playFrames = 0;
+size_t playBytes = 0;
+
+bool sameAsLeds() {
+  if (dec.lanes != NUM_STRIPS || dec.leds != NUM_LEDS) return false;
+  for (int s = 0; s < NUM_STRIPS; s++)
+    for (int i = 0; i < NUM_LEDS; i++) {
+      const CRGB &want = pixel(s, i);
+      const capture::Pixel &got = dec.frame[s][i];
+      if (got.r != want.r || got.g != want.g || got.b != want.b) return false;
+    }
+  return true;
+}
+
+// У OutNull нет show() шима: поток проверяется после каждого прохода
+void checkStream() {
+  const std::string &out = Serial.out;
+  if (out.size() == fed) return;
+  if (globalState == G_PLAYING) {
+    playFrames++;
+    playBytes += out.size() - fed;
+  }
+  dec.feed((const uint8_t *)out.data() + fed, out.size() - fed, [](const capture::Decoder &) {});
+  fed = out.size();
+  if (!sameAsLeds()) faults++;
+}
+
+// Шарик каждой дорожки на шаг дальше: кадр игры с настоящими изменениями
+void moveBalls() {
+  for (int s = 0; s < NUM_STRIPS; s++) {
+    LaneRender &r = laneRender[s];
+    markTrailDirty(s);
+    if (r.ballPos + r.ballDir < 0 || r.ballPos + r.ballDir >= NUM_LEDS) r.ballDir = -r.ballDir;
+    r.ballPos += r.ballDir;
+    markTrailDirty(s);
+  }
+}
+
+void keyFrame() { captureKeyDue = true; }
+
+void noiseFrame() {
+  static uint32_t x = 38;
+  for (int s = 0; s < NUM_STRIPS; s++)
+    for (int i = 0; i < NUM_LEDS; i++) {
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+      px(s, i) = CRGB(x, x >> 8, x >> 16);
+    }
+}
+
+// Мкс на кадр: лучшая из пяти серий
+template <class Prepare>
+double usPerFrame(Prepare prepare, unsigned long frames, size_t &bytes) {
+  double best = 1e9;
+  for (int batch = 0; batch < 5; batch++) {
+    Serial.out.clear();
+    auto t0 = std::chrono::steady_clock::now();
+    for (unsigned long k = 0; k < frames; k++) {
+      prepare();
+      composeFrame();
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    best = min(best, std::chrono::duration<double, std::micro>(t1 - t0).count() / frames);
+    bytes = Serial.out.size() / frames;
+  }
+  return best;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const unsigned long frames = argc > 1 ? strtoul(argv[1], nullptr, 10) : 300UL;
+  bootBoard();
+  Serial.setTxBufferSize(1 << 20);   // bootTasks() ставит 2048, как на плате
+  press(0, 'L');
+  for (int k = 0; k < 30000 && globalState != G_PLAYING; k++) {
+    tick();
+    checkStream();
+  }
+  CHECK_EQ(globalState, G_PLAYING);
+  for (int k = 0; k < 3000; k++) {
+    tick();
+    checkStream();
+  }
+  CHECK_EQ(faults, 0);
+  CHECK_EQ(dec.errors, 0);
+  CHECK(playFrames > 0);
+
+  size_t playFrameBytes = 0, keyFrameBytes = 0, noiseFrameBytes = 0;
+  const double playUs = usPerFrame(moveBalls, frames, playFrameBytes);
+  const double keyUs = usPerFrame(keyFrame, frames, keyFrameBytes);
+  const double noiseUs = usPerFrame(noiseFrame, frames, noiseFrameBytes);
+  printf("bench_capture: %d lanes x %d leds, %lu frames\n", NUM_STRIPS, NUM_LEDS, frames);
+  printf("  in play: %.0f B/frame over %lu frames\n", (double)playBytes / playFrames, playFrames);
+  printf("  game frame: %.1f us, %zu B (%.0f fps)\n", playUs, playFrameBytes, 1e6 / playUs);
+  printf("  key frame:  %.1f us, %zu B (%.0f fps)\n", keyUs, keyFrameBytes, 1e6 / keyUs);
+  printf("  noise:      %.1f us, %zu B (%.0f fps)\n", noiseUs, noiseFrameBytes, 1e6 / noiseUs);
+  CHECK(noiseFrameBytes >= (size_t)NUM_STRIPS * NUM_LEDS * 3);
+  CHECK(1e6 / playUs >= CAPTURE_MIN_FPS);
+  CHECK(1e6 / keyUs >= CAPTURE_MIN_FPS);
+  CHECK(1e6 / noiseUs >= CAPTURE_MIN_FPS);
+  return report("bench_capture");
+}
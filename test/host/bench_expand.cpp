@@ -0,0 +1,75 @@
+// Цена развёртки слоёв в leds[] против времени передачи кадра.
+// leds[] полноразмерный: драйверы RMT/I2S читают его во время передачи,
+// а компоновщик пишет только грязный диапазон. Общий буфер передачи на
+// все контроллеры заставил бы разворачивать каждую ленту целиком перед
+// каждым показом — бенчмарк меряет обе развёртки на одном состоянии
+// посреди матча и сравнивает с временем провода одного контроллера.
+// Числа хоста, не ESP32: на плате то же соотношение даёт строка RENDER:.
+// Без санитайзеров (PLAIN):
+//   bench_expand [кадров, по умолчанию 20000]
+#include SKETCH
+#include "host.h"
+
+#include <chrono>
+
+using namespace host;
+
+namespace {
+
+// Грязный диапазон кадра, где сдвинулся только шарик
+void markBallFrame(int s) {
+  const LaneRender &r = laneRender[s];
+  markDirty(s, r.ballPos - TRAIL_LEN - 1, r.ballPos + TRAIL_LEN + 1);
+}
+
+void markWholeLane(int s) { markDirty(s, 0, NUM_LEDS - 1); }
+
+template <class Mark>
+double usPerFrame(Mark mark, unsigned long frames) {
+  auto t0 = std::chrono::steady_clock::now();
+  for (unsigned long k = 0; k < frames; k++)
+    for (int s = 0; s < NUM_STRIPS; s++) {
+      mark(s);
+      composeLane(s);
+    }
+  auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(t1 - t0).count() / frames;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  unsigned long frames = argc > 1 ? strtoul(argv[1], nullptr, 10) : 20000UL;
+  bootBoard();
+  run(1000);
+  press(0, 'L');
+  run(3000);
+  CHECK_EQ(globalState, G_PLAYING);
+
+  // Пикселей на кадр в настоящей игре — по счётчику скетча
+  uint32_t writes0 = pixelWrites;
+  const int shows0 = shows;
+  run(5000);
+  const double writesPerFrame = (double)(pixelWrites - writes0) / max(1, shows - shows0);
+
+  // Обе развёртки дают тот же кадр
+  static CRGB incremental[NUM_CONTROLLERS][CTRL_LEDS];
+  for (int s = 0; s < NUM_STRIPS; s++) composeLane(s);
+  memcpy(incremental, leds, sizeof(leds));
+  for (int s = 0; s < NUM_STRIPS; s++) {
+    markWholeLane(s);
+    composeLane(s);
+  }
+  CHECK(memcmp(incremental, leds, sizeof(leds)) == 0);
+
+  const double ballUs = usPerFrame(markBallFrame, frames);
+  const double fullUs = usPerFrame(markWholeLane, frames);
+  const double wireUs = (double)CTRL_LEDS * LED_OUTPUT::WIRE_NS_PER_LED / 1000;
+
+  printf("bench_expand: %d lanes x %d leds, %.1f px/frame in play\n", NUM_STRIPS, NUM_LEDS, writesPerFrame);
+  printf("  expand ball only %.3f us/frame, whole lanes %.3f us/frame (host)\n", ballUs, fullUs);
+  printf("  wire %.0f us per controller (%s)\n", wireUs, LED_OUTPUT::name());
+  printf("  RAM: leds %zu B, layer state %zu B\n", sizeof(leds), sizeof(laneRender));
+  CHECK(fullUs >= ballUs);
+  return report("bench_expand");
+}
@@ -0,0 +1,81 @@
+// Микробенчмарк проверки попадания. Прежний путь пересчитывал четыре
+// границы зон из счёта на каждое нажатие и сравнивал дважды; теперешний —
+// zoneOffset() по зонам, хранимым в дорожке, одно беззнаковое сравнение.
+// Сначала оба пути сверяются на всех счётах и положениях, затем меряются
+// на одном наборе случайных положений. Без санитайзеров (PLAIN):
+//   bench_hit [итераций, по умолчанию 20000000]
+#include SKETCH
+#include "host.h"
+
+#include <chrono>
+#include <random>
+
+using namespace host;
+
+namespace {
+
+// Прежняя проверка, как до хранения зон в дорожке
+HitGrade judgeFromScore(const StripGame &g, int seen, bool leftSide) {
+  int leftStart = GAME_MODE::zoneShift(g.scoreL);
+  int rightStart = NUM_LEDS - 1 - g.hitZone - GAME_MODE::zoneShift(g.scoreR);
+  int zoneStart = leftSide ? leftStart : rightStart;
+  int zoneEnd = zoneStart + g.hitZone;
+  if (seen < zoneStart || seen > zoneEnd) return HIT_MISS;
+
+  int offset = leftSide ? seen - zoneStart : zoneEnd - seen;
+  if (offset * 3 > g.hitZone * 2) return HIT_EARLY;
+  if (offset * 3 < g.hitZone) return HIT_LATE;
+  return HIT_PERFECT;
+}
+
+__attribute__((noinline)) HitGrade oldPath(const StripGame &g, int seen, bool leftSide) {
+  return judgeFromScore(g, seen, leftSide);
+}
+
+__attribute__((noinline)) HitGrade newPath(const StripGame &g, int seen, bool leftSide) {
+  return judgeHit(g, seen, leftSide);
+}
+
+template <class F>
+double nsPerCall(F judge, const StripGame &g, const std::vector<int16_t> &pos, unsigned long iters,
+                 unsigned &sum) {
+  auto t0 = std::chrono::steady_clock::now();
+  for (unsigned long k = 0; k < iters; k++) {
+    int p = pos[k & (pos.size() - 1)];
+    sum += judge(g, p, k & 1);
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(t1 - t0).count() / iters;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  unsigned long iters = argc > 1 ? strtoul(argv[1], nullptr, 10) : 20000000UL;
+  bootBoard();
+
+  StripGame g = game[0];
+  g.hitZone = rules.hitZone;
+  for (int l = 0; l < rules.maxScore; l += rules.scoreStep)
+    for (int r = 0; r < rules.maxScore; r += rules.scoreStep) {
+      g.scoreL = l;
+      g.scoreR = r;
+      updateZones<GAME_MODE>(g);
+      for (int p = -2; p < NUM_LEDS + 2; p++)
+        for (bool left : {true, false}) CHECK_EQ(judgeHit(g, p, left), judgeFromScore(g, p, left));
+    }
+
+  // Счёт посередине матча, положения по всей ленте и чуть за краями
+  g.scoreL = g.scoreR = rules.maxScore / 2 / rules.scoreStep * rules.scoreStep;
+  updateZones<GAME_MODE>(g);
+  std::mt19937 rng(45);
+  std::vector<int16_t> pos(4096);
+  for (int16_t &p : pos) p = (int)(rng() % (NUM_LEDS + 4)) - 2;
+
+  unsigned sumOld = 0, sumNew = 0;
+  double oldNs = nsPerCall(oldPath, g, pos, iters, sumOld);
+  double newNs = nsPerCall(newPath, g, pos, iters, sumNew);
+  CHECK_EQ(sumOld, sumNew);
+  printf("bench_hit: %lu calls, from score %.2f ns, stored zones %.2f ns\n", iters, oldNs, newNs);
+  return report("bench_hit");
+}
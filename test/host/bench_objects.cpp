@@ -0,0 +1,120 @@
+// Худший кадр игры при полных пулах объектов (ModeMultiBall: OBJ_POOL
+// на каждой дорожке). Матч без отбиваний; после каждого показанного
+// кадра состояние снимается, и следующий кадр — updateStrip() всех
+// дорожек и компоновка — повторяется со снимка. В снимке на каждой
+// дорожке шагают и мяч, и препятствия (худший шаг). Тот же кадр с
+// пустыми пулами — для сравнения. Без отбиваний матч обязан кончиться:
+// мяч, застрявший у препятствия, его бы не отпустил. Числа хоста, не ESP32.
+// Без санитайзеров (PLAIN):
+//   bench_objects [повторов кадра, по умолчанию 40]
+#include SKETCH
+#include "host.h"
+
+#include <chrono>
+
+using namespace host;
+
+#define STR_(x) #x
+#define STR(x)  STR_(x)
+
+namespace {
+
+struct Snapshot {
+  StripGame game[NUM_STRIPS];
+  LaneRender render[NUM_STRIPS];
+  ObjectPool pools[NUM_STRIPS];
+  LaneOutbox outbox[NUM_STRIPS];
+  CRGB leds[NUM_CONTROLLERS][CTRL_LEDS];
+};
+
+Snapshot snap;
+
+void take() {
+  memcpy(snap.game, game, sizeof(game));
+  memcpy(snap.render, laneRender, sizeof(laneRender));
+  memcpy(snap.pools, pools, sizeof(pools));
+  memcpy(snap.outbox, outbox, sizeof(outbox));
+  memcpy(snap.leds, leds, sizeof(leds));
+}
+
+void restore() {
+  memcpy(game, snap.game, sizeof(game));
+  memcpy(laneRender, snap.render, sizeof(laneRender));
+  memcpy(pools, snap.pools, sizeof(pools));
+  memcpy(outbox, snap.outbox, sizeof(outbox));
+  memcpy(leds, snap.leds, sizeof(leds));
+}
+
+// Кадр со снимка в момент t, мкс на кадр: лучшая из пяти серий, чтобы
+// вытеснение процесса не выдавало себя за худший кадр
+double usPerFrame(unsigned long t, int repeats) {
+  double best = 1e9;
+  for (int batch = 0; batch < 5; batch++) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (int k = 0; k < repeats; k++) {
+      restore();
+      for (int s = 0; s < NUM_STRIPS; s++) updateStrip<GAME_MODE>(s, t);
+      composeFrame();
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    best = min(best, std::chrono::duration<double, std::micro>(t1 - t0).count() / repeats);
+  }
+  return best;
+}
+
+bool shownInPlay = false;
+
+void onFrame() { shownInPlay = globalState == G_PLAYING; }
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const int repeats = argc > 1 ? atoi(argv[1]) : 40;
+  onShow = onFrame;
+  bootBoard();
+  press(0, 'L');
+  for (int k = 0; k < 5000 && globalState != G_PLAYING; k++) tick();
+  CHECK_EQ(globalState, G_PLAYING);
+
+  int samples = 0, notFull = 0;
+  double worstFull = 0, worstEmpty = 0, sumFull = 0;
+  for (int k = 0; k < 300000 && globalState == G_PLAYING; k++) {
+    shownInPlay = false;
+    tick();
+    if (!shownInPlay) continue;
+
+    // Следующий кадр со снимка: мяч и препятствия каждой живой дорожки
+    // шагают. Сама игра идёт дальше с настоящего состояния
+    const unsigned long t = gameNow() + GAME_DELAY;
+    take();
+    static Snapshot live;
+    live = snap;
+    bool anyLive = false;
+    for (int s = 0; s < NUM_STRIPS; s++) {
+      if (snap.game[s].state != PLAYING) continue;
+      anyLive = true;
+      notFull += snap.pools[s].count != OBJ_POOL;
+      snap.game[s].lastMove = t - snap.game[s].speedDelay;
+      snap.pools[s].tick = OBSTACLE_PERIOD - 1;
+    }
+    if (!anyLive) continue;
+    const double full = usPerFrame(t, repeats);
+    for (int s = 0; s < NUM_STRIPS; s++) snap.pools[s].count = 0;
+    const double empty = usPerFrame(t, repeats);
+    samples++;
+    sumFull += full;
+    worstFull = max(worstFull, full);
+    worstEmpty = max(worstEmpty, empty);
+    snap = live;
+    restore();
+  }
+  CHECK(globalState != G_PLAYING);   // мячи не застревают у препятствий, матч кончается
+  CHECK(samples > 0);
+  CHECK_EQ(notFull, 0);
+  printf("bench_objects: %d lanes x %d objects (%s), %d frames x %d repeats\n", NUM_STRIPS, OBJ_POOL,
+         STR(GAME_MODE), samples, repeats);
+  printf("  game frame: full pools worst %.3f us (mean %.3f), empty pools worst %.3f us, budget %d us\n",
+         worstFull, sumFull / max(1, samples), worstEmpty, GAME_DELAY * 1000);
+  CHECK(worstFull < GAME_DELAY * 1000);
+  return report("bench_objects");
+}
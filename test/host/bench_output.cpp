@@ -0,0 +1,71 @@
+// Достижимая частота кадров выхода: развёртка слоёв и show() бэкенда
+// (composeFrame() + LED_OUTPUT::show(), как showAll()) плюс время провода
+// по оценке скетча: WIRE_US на кадр, а у OutClocked, где контроллеры
+// передаются по очереди, — на каждый контроллер. Кадр посреди матча —
+// сдвинулся только шарик — и кадр, где перерисованы все дорожки.
+// Развёртка меряется по часам хоста, поэтому сумма — оценка, а не замер
+// ESP32: на плате время показа даёт строка OUT:, развёртку — RENDER:.
+// Варианты bench_output_clocked и bench_output_null — другие бэкенды.
+// Без санитайзеров (PLAIN):
+//   bench_output [кадров, по умолчанию 5000]
+#include SKETCH
+#include "host.h"
+
+#include <chrono>
+
+using namespace host;
+
+namespace {
+
+void markBallFrame(int s) {
+  const LaneRender &r = laneRender[s];
+  markDirty(s, r.ballPos - r.trailLen - 1, r.ballPos + r.trailLen + 1);
+}
+
+void markWholeLane(int s) { markDirty(s, 0, NUM_LEDS - 1); }
+
+// Мкс на showAll(): лучшая из пяти серий
+template <class Mark>
+double usPerShow(Mark mark, unsigned long frames) {
+  double best = 1e9;
+  for (int batch = 0; batch < 5; batch++) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (unsigned long k = 0; k < frames; k++) {
+      for (int s = 0; s < NUM_STRIPS; s++) mark(s);
+      showAll();
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    best = min(best, std::chrono::duration<double, std::micro>(t1 - t0).count() / frames);
+  }
+  return best;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const unsigned long frames = argc > 1 ? strtoul(argv[1], nullptr, 10) : 5000UL;
+  bootBoard();
+  press(0, 'L');
+  run(3000);
+  CHECK_EQ(globalState, G_PLAYING);
+
+  const int shows0 = shows + ctrlShows;
+  const double ballUs = usPerShow(markBallFrame, frames);
+  const double fullUs = usPerShow(markWholeLane, frames);
+  // каждый showAll() дошёл до лент; у OutNull лент нет
+  CHECK_EQ(shows + ctrlShows - shows0, LED_OUTPUT::WIRE_NS_PER_LED ? 10 * (int)frames : 0);
+  const unsigned long wire =
+    !LED_OUTPUT::WIRE_NS_PER_LED ? 0 : LED_OUTPUT::PARALLEL_SHOW ? WIRE_US : WIRE_US * NUM_CONTROLLERS;
+
+  const double fpsBall = 1e6 / (ballUs + wire);
+  const double fpsFull = 1e6 / (fullUs + wire);
+  printf("bench_output: %s, %d controllers x %d leds, %lu frames\n", LED_OUTPUT::name(), NUM_CONTROLLERS,
+         CTRL_LEDS, frames);
+  printf("  compose+show ball only %.3f us, whole lanes %.3f us (host), wire %lu us\n", ballUs, fullUs,
+         wire);
+  printf("  max fps: ball only %.0f, whole lanes %.0f (game frame %d ms = %d fps)\n", fpsBall, fpsFull, GAME_DELAY,
+         1000 / GAME_DELAY);
+  CHECK(fullUs >= ballUs);
+  CHECK(fpsFull * GAME_DELAY >= 1000);
+  return report("bench_output");
+}
@@ -0,0 +1,127 @@
+// Цена правил из профиля на кадр игры. Прежние скетчи читали HIT_ZONE,
+// SCORE_STEP, MAX_SCORE и SPEED_DELAY как константы; теперь кадр читает
+// rules и поля дорожки, посчитанные при загрузке (зоны, hitZone,
+// speedDelay). Кадр игры — updateStrip() всех дорожек и компоновка —
+// меряется на одном состоянии посреди матча дважды: с правилами по
+// умолчанию и после горячей загрузки того же профиля строкой RULES по
+// Serial. Кадры обязаны совпасть байт в байт. Отдельно, как в bench_hit,
+// конец дорожки по rules.maxScore против константы MAX_SCORE.
+// Числа хоста, не ESP32. Без санитайзеров (PLAIN):
+//   bench_rules [кадров, по умолчанию 200000]
+#include SKETCH
+#include "host.h"
+
+#include <chrono>
+#include <random>
+
+using namespace host;
+
+namespace {
+
+// Всё, что трогает кадр игры
+struct Snapshot {
+  StripGame game[NUM_STRIPS];
+  LaneRender render[NUM_STRIPS];
+  ObjectPool pools[NUM_STRIPS];
+  LaneOutbox outbox[NUM_STRIPS];
+  CRGB leds[NUM_CONTROLLERS][CTRL_LEDS];
+};
+
+Snapshot snap;
+
+void take() {
+  memcpy(snap.game, game, sizeof(game));
+  memcpy(snap.render, laneRender, sizeof(laneRender));
+  memcpy(snap.pools, pools, sizeof(pools));
+  memcpy(snap.outbox, outbox, sizeof(outbox));
+  memcpy(snap.leds, leds, sizeof(leds));
+}
+
+void restore() {
+  memcpy(game, snap.game, sizeof(game));
+  memcpy(laneRender, snap.render, sizeof(laneRender));
+  memcpy(pools, snap.pools, sizeof(pools));
+  memcpy(outbox, snap.outbox, sizeof(outbox));
+  memcpy(leds, snap.leds, sizeof(leds));
+}
+
+// Кадр игры со снимка в момент t, мкс на кадр; кадр остаётся в leds[]
+double usPerFrame(unsigned long t, unsigned long frames) {
+  auto t0 = std::chrono::steady_clock::now();
+  for (unsigned long k = 0; k < frames; k++) {
+    restore();
+    for (int s = 0; s < NUM_STRIPS; s++) updateStrip<GAME_MODE>(s, t);
+    composeFrame();
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(t1 - t0).count() / frames;
+}
+
+__attribute__((noinline)) bool overFromRules(const StripGame &g) {
+  return g.scoreL >= rules.maxScore || g.scoreR >= rules.maxScore;
+}
+
+__attribute__((noinline)) bool overFromMacro(const StripGame &g) {
+  return g.scoreL >= MAX_SCORE || g.scoreR >= MAX_SCORE;
+}
+
+template <class F>
+double nsPerCall(F over, const std::vector<StripGame> &lanes, unsigned long iters, unsigned &sum) {
+  auto t0 = std::chrono::steady_clock::now();
+  for (unsigned long k = 0; k < iters; k++) sum += over(lanes[k & (lanes.size() - 1)]);
+  auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(t1 - t0).count() / iters;
+}
+
+// Профиль по умолчанию строкой RULES
+std::string defaultRulesLine() {
+  char line[RULES_LINE_MAX];
+  const RuleProfile &p = DEFAULT_RULES;
+  snprintf(line, sizeof(line), "RULES %u %u %u %u %02X%02X%02X %02X%02X%02X %02X%02X%02X\n", p.hitZone,
+           p.scoreStep, p.maxScore, p.speedDelay, p.colorLeft.r, p.colorLeft.g, p.colorLeft.b, p.colorRight.r,
+           p.colorRight.g, p.colorRight.b, p.colorBall.r, p.colorBall.g, p.colorBall.b);
+  return line;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  unsigned long frames = argc > 1 ? strtoul(argv[1], nullptr, 10) : 200000UL;
+  bootBoard();
+  press(0, 'L');
+  run(3000);
+  CHECK_EQ(globalState, G_PLAYING);
+  take();
+  const unsigned long t = millis() + GAME_DELAY;
+
+  const double defaultUs = usPerFrame(t, frames);
+  static CRGB fromDefaults[NUM_CONTROLLERS][CTRL_LEDS];
+  memcpy(fromDefaults, leds, sizeof(leds));
+
+  // Тот же профиль по Serial, применён как между матчами
+  Serial.feed(defaultRulesLine().c_str());
+  pollSerialRules();
+  CHECK(rulesPending);
+  applyPendingRules();
+  CHECK_EQ(lines("RULES: applied").size(), 1);
+  const double reloadedUs = usPerFrame(t, frames);
+  CHECK(memcmp(fromDefaults, leds, sizeof(leds)) == 0);
+
+  // Конец дорожки: поле профиля против константы
+  std::mt19937 rng(28);
+  std::vector<StripGame> lanes(1024, game[0]);
+  for (StripGame &g : lanes) {
+    g.scoreL = rng() % (MAX_SCORE + rules.scoreStep);
+    g.scoreR = rng() % (MAX_SCORE + rules.scoreStep);
+  }
+  unsigned sumRules = 0, sumMacro = 0;
+  const double rulesNs = nsPerCall(overFromRules, lanes, frames * 100, sumRules);
+  const double macroNs = nsPerCall(overFromMacro, lanes, frames * 100, sumMacro);
+  CHECK_EQ(sumRules, sumMacro);
+
+  printf("bench_rules: %d lanes, %lu frames\n", NUM_STRIPS, frames);
+  printf("  game frame: default rules %.3f us, reloaded over Serial %.3f us (%+.1f%%)\n", defaultUs, reloadedUs,
+         (reloadedUs / defaultUs - 1) * 100);
+  printf("  lane over: rules.maxScore %.2f ns, MAX_SCORE %.2f ns\n", rulesNs, macroNs);
+  return report("bench_rules");
+}
@@ -0,0 +1,159 @@
+// Сценарии на Timeline против прежних автоматов на глобальных
+// переменных (fillPos, lastFillUpdate, blinkCount, blinkState, lastBlink),
+// как до перехода на TL_BEGIN/TL_FRAME. Заполнение и мигание конца матча
+// опрашиваются каждую миллисекунду, как из loop(); сначала оба пути
+// сверяются по кадрам (когда показан и что в leds[]), затем меряется
+// цена опроса — большинство опросов только ждёт. Числа хоста, не ESP32.
+// Без санитайзеров (PLAIN):
+//   bench_timeline [повторов сценария, по умолчанию 2000]
+#include SKETCH
+#include "host.h"
+
+#include <chrono>
+
+using namespace host;
+
+namespace {
+
+// Прежнее заполнение
+int fillPos = 0;
+unsigned long lastFillUpdate = 0;
+
+void handFillBegin() {
+  fillPos = 0;
+  lastFillUpdate = millis() - FILL_DELAY;
+  setGlobalState(G_START_FILL);
+}
+
+__attribute__((noinline)) bool handFill() {
+  unsigned long now = millis();
+  if (now - lastFillUpdate < FILL_DELAY) return false;
+  lastFillUpdate = now;
+  for (int s = 0; s < NUM_STRIPS; s++)
+    setBars(s, fillPos + 1, fillPos + 1);
+  fillPos++;
+  if (fillPos >= NUM_LEDS / 2) startMatch();
+  return true;
+}
+
+// Прежнее мигание
+int blinkCount = 0;
+bool blinkState = false;
+unsigned long lastBlink = 0;
+
+void handBlinkBegin() {
+  blinkCount = 0;
+  blinkState = false;
+  lastBlink = millis();
+  setGlobalState(G_GAME_OVER_ANIM);
+}
+
+__attribute__((noinline)) bool handBlink() {
+  unsigned long now = millis();
+  if (now - lastBlink < BLINK_DELAY) return false;
+  lastBlink = now;
+  blinkState = !blinkState;
+  blinkCount++;
+  for (int s = 0; s < NUM_STRIPS; s++)
+    setLaneFill(s, blinkState ? gameOverColor : CRGB(CRGB::Black));
+  if (blinkCount >= BLINK_TOGGLES) endMatch();
+  return true;
+}
+
+void tlFillBegin() {
+  anim = Timeline();
+  setGlobalState(G_START_FILL);
+}
+
+void tlBlinkBegin() {
+  anim = Timeline();
+  setGlobalState(G_GAME_OVER_ANIM);
+}
+
+__attribute__((noinline)) bool tlFill() { return startFillAnimation(); }
+__attribute__((noinline)) bool tlBlink() { return gameOverAnimation(); }
+
+// Показанные кадры сценария: миллисекунда от начала и leds[]
+struct Trace {
+  std::vector<unsigned long> at;
+  std::string frames;
+  unsigned long calls = 0;
+};
+
+// Опрос каждую миллисекунду, пока автомат не покинет состояние
+template <class Begin, class Step>
+Trace play(Begin begin, Step step, bool record) {
+  Trace tr;
+  const GlobalState state = (begin(), globalState);
+  const unsigned long t0 = millis();
+  for (int ms = 0; ms < 60000 && globalState == state; ms++) {
+    tr.calls++;
+    if (step() && record) {
+      composeFrame();
+      tr.at.push_back(millis() - t0);
+      tr.frames.append((const char *)leds, sizeof(leds));
+    }
+    advance(1000);
+  }
+  return tr;
+}
+
+// Наносекунд на опрос: лучшая из пяти серий по repeats сценариев
+template <class Begin, class Step>
+double nsPerCall(Begin begin, Step step, int repeats) {
+  double best = 1e18;
+  for (int batch = 0; batch < 5; batch++) {
+    unsigned long calls = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int k = 0; k < repeats; k++) calls += play(begin, step, false).calls;
+    auto t1 = std::chrono::steady_clock::now();
+    best = min(best, std::chrono::duration<double, std::nano>(t1 - t0).count() / calls);
+  }
+  return best;
+}
+
+void resetLanes() {
+  endMatch();
+  resetAllLanes();
+  composeFrame();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const int repeats = argc > 1 ? atoi(argv[1]) : 2000;
+  bootBoard();
+  gameOverColor = laneColor(0, PAL_LEFT);
+
+  resetLanes();
+  const Trace handF = play(handFillBegin, handFill, true);
+  resetLanes();
+  const Trace tlF = play(tlFillBegin, tlFill, true);
+  CHECK_EQ(tlF.at.size(), (size_t)NUM_LEDS / 2);
+  CHECK(tlF.at == handF.at);
+  CHECK(tlF.frames == handF.frames);
+
+  const Trace handB = play(handBlinkBegin, handBlink, true);
+  resetLanes();
+  play(tlFillBegin, tlFill, false);
+  const Trace tlB = play(tlBlinkBegin, tlBlink, true);
+  CHECK_EQ(tlB.at.size(), (size_t)BLINK_TOGGLES);
+  CHECK(tlB.at == handB.at);
+  CHECK(tlB.frames == handB.frames);
+
+  const double handFillNs = nsPerCall(handFillBegin, handFill, repeats);
+  const double tlFillNs = nsPerCall(tlFillBegin, tlFill, repeats);
+  const double handBlinkNs = nsPerCall(handBlinkBegin, handBlink, repeats / 4);
+  const double tlBlinkNs = nsPerCall(tlBlinkBegin, tlBlink, repeats / 4);
+  printf("bench_timeline: %d repeats, ns per poll (host)\n", repeats);
+  printf("  start fill: hand-written %.2f, timeline %.2f (%lu polls, %zu frames)\n", handFillNs, tlFillNs,
+         tlF.calls, tlF.at.size());
+  printf("  game over:  hand-written %.2f, timeline %.2f (%lu polls, %zu frames)\n", handBlinkNs, tlBlinkNs,
+         tlB.calls, tlB.at.size());
+  printf("  RAM: Timeline %zu B for both, globals %zu B\n", sizeof(Timeline),
+         sizeof(fillPos) + sizeof(lastFillUpdate) + sizeof(blinkCount) + sizeof(blinkState) + sizeof(lastBlink));
+  // Запас на шум хоста: опрос стоит единицы наносекунд
+  CHECK(tlFillNs <= handFillNs * 1.5 + 2);
+  CHECK(tlBlinkNs <= handBlinkNs * 1.5 + 2);
+  return report("bench_timeline");
+}
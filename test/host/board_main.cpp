@@ -0,0 +1,90 @@
+// Плата шкафа отдельным процессом на настоящих часах: SHARD_UART
+// (Serial2) — устройство, Serial — stdout. test_shards соединяет
+// несколько плат через PTY; так же плату можно посадить на настоящий
+// порт или socat:
+//   board_<роль> <устройство> <мс работы> [ход часов] [сдвиг мс] [<дорожка><L|R>@<мс> ...]
+// Ход и сдвиг — часы платы относительно настоящих, нажатия — в мс от
+// запуска по часам платы. В конце печатается BOARD: с разностью времени игры и
+// CLOCK_MONOTONIC, по которой сверяют фазу плат
+#include SKETCH
+#include "host.h"
+
+#include <fcntl.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace host;
+
+namespace {
+
+struct Press {
+  int lane;
+  char side;
+  unsigned long atMs;
+  bool down, done;
+};
+
+long long monotonicMs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+int openUart(const char *path) {
+  int fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (fd < 0) return -1;
+  termios t;
+  if (tcgetattr(fd, &t) == 0) {
+    cfmakeraw(&t);
+    tcsetattr(fd, TCSANOW, &t);
+  }
+  return fd;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    fprintf(stderr, "board: <устройство> <мс работы> [ход часов] [сдвиг мс] [<дорожка><L|R>@<мс> ...]\n");
+    return 2;
+  }
+  setvbuf(stdout, nullptr, _IOLBF, 0);
+  realtime = true;
+  unsigned long runMs = strtoul(argv[2], nullptr, 10);
+  if (argc > 3) clockRate = atof(argv[3]);
+  if (argc > 4) clockOffsetUs = atoll(argv[4]) * 1000;
+  std::vector<Press> presses;
+  for (int k = 5; k < argc; k++) {
+    Press p{};
+    if (sscanf(argv[k], "%d%c@%lu", &p.lane, &p.side, &p.atMs) == 3 && p.lane < NUM_STRIPS) presses.push_back(p);
+  }
+
+  Serial2.fd = openUart(argv[1]);
+  if (Serial2.fd < 0) {
+    perror(argv[1]);
+    return 2;
+  }
+  Serial.echo = true;
+
+  setup();
+  const unsigned long startMs = millis();
+  while (millis() - startMs < runMs) {
+    loop();
+    unsigned long ms = millis() - startMs;
+    for (Press &p : presses) {
+      if (!p.down && ms >= p.atMs) {
+        hold(p.lane, p.side);
+        p.down = true;
+      } else if (p.down && !p.done && ms >= p.atMs + 60) {
+        release(p.lane, p.side);
+        p.done = true;
+      }
+    }
+    usleep(200);
+  }
+
+  printf("BOARD: shard %d state %d game-mono %lld\n", SHARD_ID, globalState,
+         (long long)gameNow() - monotonicMs());
+  return invariantFaults ? 1 : 0;
+}
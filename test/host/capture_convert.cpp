@@ -0,0 +1,124 @@
+// Поток CAPTURE в видео или картинку:
+//   capture_convert [--fps N] [--scale K] поток.bin кадры.y4m
+//       Y4M (C444) с постоянной частотой: строка дорожки высотой K
+//       пикселей, между кадрами потока повторяется последний показанный
+//   capture_convert --timeline поток.bin лента.ppm
+//       PPM: строка на каждый кадр потока, дорожки рядом через чёрный столбец
+// Y4M и PPM читают ffmpeg и ImageMagick (PNG/GIF — ffmpeg -i кадры.y4m кадры.gif)
+#include "capture_decode.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using capture::Decoder;
+using capture::Pixel;
+
+namespace {
+
+FILE *out = nullptr;
+unsigned fps = 50;
+unsigned scale = 4;
+bool timeline = false;
+
+std::vector<std::vector<Pixel>> shown;   // кадр, который сейчас на видео
+bool started = false;
+uint64_t nextUs = 0;                     // время следующего кадра видео от начала потока
+uint32_t firstMs = 0;
+unsigned written = 0;
+
+std::vector<std::vector<Pixel>> rows;    // --timeline: строки картинки
+
+// BT.601, ограниченный диапазон, как ждёт Y4M по умолчанию
+void writeY4mFrame() {
+  if (shown.empty()) return;
+  const size_t w = shown[0].size(), h = shown.size() * scale;
+  std::vector<uint8_t> plane[3];
+  for (auto &pl : plane) pl.resize(w * h);
+  for (size_t lane = 0; lane < shown.size(); lane++) {
+    for (size_t i = 0; i < w; i++) {
+      const Pixel &c = shown[lane][i];
+      int y = 16 + (66 * c.r + 129 * c.g + 25 * c.b + 128) / 256;
+      int u = 128 + (-38 * c.r - 74 * c.g + 112 * c.b + 128) / 256;
+      int v = 128 + (112 * c.r - 94 * c.g - 18 * c.b + 128) / 256;
+      for (unsigned k = 0; k < scale; k++) {
+        size_t at = (lane * scale + k) * w + i;
+        plane[0][at] = y;
+        plane[1][at] = u;
+        plane[2][at] = v;
+      }
+    }
+  }
+  fputs("FRAME\n", out);
+  for (auto &pl : plane) fwrite(pl.data(), 1, pl.size(), out);
+  written++;
+}
+
+void onFrame(const Decoder &d) {
+  if (timeline) {
+    std::vector<Pixel> row;
+    for (int lane = 0; lane < d.lanes; lane++) {
+      if (lane) row.push_back(Pixel{0, 0, 0});
+      row.insert(row.end(), d.frame[lane].begin(), d.frame[lane].end());
+    }
+    rows.push_back(row);
+    return;
+  }
+
+  if (!started) {
+    fprintf(out, "YUV4MPEG2 W%d H%u F%u:1 Ip A1:1 C444\n", d.leds, d.lanes * scale, fps);
+    started = true;
+    firstMs = d.ms;
+  }
+  // До времени этого кадра на видео держится предыдущий
+  const uint64_t at = (uint64_t)(d.ms - firstMs) * 1000;
+  while (!shown.empty() && nextUs < at) {
+    writeY4mFrame();
+    nextUs += 1000000 / fps;
+  }
+  shown = d.frame;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  std::vector<const char *> files;
+  for (int k = 1; k < argc; k++) {
+    std::string a = argv[k];
+    if (a == "--fps" && k + 1 < argc) fps = std::max(1, atoi(argv[++k]));
+    else if (a == "--scale" && k + 1 < argc) scale = std::max(1, atoi(argv[++k]));
+    else if (a == "--timeline") timeline = true;
+    else files.push_back(argv[k]);
+  }
+  if (files.size() != 2) {
+    fprintf(stderr, "capture_convert [--fps N] [--scale K] [--timeline] поток.bin выход\n");
+    return 2;
+  }
+
+  FILE *in = fopen(files[0], "rb");
+  out = fopen(files[1], "wb");
+  if (!in || !out) {
+    perror("capture_convert");
+    return 2;
+  }
+
+  Decoder d;
+  uint8_t buf[1 << 16];
+  for (size_t n; (n = fread(buf, 1, sizeof(buf), in)) > 0;) d.feed(buf, n, onFrame);
+  fclose(in);
+
+  if (timeline) {
+    size_t w = rows.empty() ? 0 : rows[0].size();
+    fprintf(out, "P6\n%zu %zu\n255\n", w, rows.size());
+    for (const auto &row : rows) fwrite(row.data(), 3, row.size(), out);
+    written = rows.size();
+  } else {
+    writeY4mFrame();   // последний кадр потока
+  }
+  fclose(out);
+
+  printf("capture_convert: кадров потока %u (полных %u, ошибок %u), записано %u\n",
+         d.frames, d.keys, d.errors, written);
+  return d.frames && !d.errors ? 0 : 1;
+}
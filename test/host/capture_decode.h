@@ -0,0 +1,106 @@
+// Разбор потока CAPTURE (формат — в разделе CAPTURE скетча). Декодер
+// держит свою копию кадра по дорожкам и обновляет её участками; байты
+// вне пакетов (текстовые логи) пропускаются до метки A5 5A
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace capture {
+
+struct Pixel {
+  uint8_t r, g, b;
+  bool operator==(const Pixel &o) const { return r == o.r && g == o.g && b == o.b; }
+  bool operator!=(const Pixel &o) const { return !(*this == o); }
+};
+
+class Decoder {
+public:
+  int lanes = 0;
+  int leds = 0;
+  std::vector<std::vector<Pixel>> frame;   // [дорожка][пиксель]
+  uint32_t ms = 0;                         // время последнего кадра
+  unsigned frames = 0;
+  unsigned keys = 0;
+  unsigned errors = 0;                     // битые пакеты
+
+  // Добавить байты; для каждого целого кадра вызывается onFrame(*this)
+  template <class F>
+  void feed(const uint8_t *p, size_t n, F onFrame) {
+    buf.insert(buf.end(), p, p + n);
+    size_t at = 0;
+    for (;;) {
+      size_t used = 0;
+      int r = packet(at, used);
+      if (r == NEED_MORE) break;
+      if (r == FRAME) onFrame(*this);
+      at += used;
+    }
+    buf.erase(buf.begin(), buf.begin() + at);
+  }
+
+private:
+  enum { NEED_MORE, SKIP, HEADER, FRAME };
+  std::vector<uint8_t> buf;
+
+  static uint16_t u16(const uint8_t *p) { return p[0] | p[1] << 8; }
+
+  // Пакет с позиции at: used — сколько байт он занял
+  int packet(size_t at, size_t &used) {
+    const size_t n = buf.size() - at;
+    const uint8_t *p = buf.data() + at;
+    if (n < 3) return NEED_MORE;
+    if (p[0] != 0xA5 || p[1] != 0x5A) {
+      used = 1;
+      return SKIP;
+    }
+    if (p[2] == 'H') {
+      if (n < 6) return NEED_MORE;
+      lanes = p[3];
+      leds = u16(p + 4);
+      frame.assign(lanes, std::vector<Pixel>(leds, Pixel{0, 0, 0}));
+      keys++;
+      used = 6;
+      return HEADER;
+    }
+    if (p[2] != 'F') {
+      used = 1;
+      return SKIP;
+    }
+
+    // Кадр применяется только целиком: сначала проверяем, что он полный
+    size_t k = 7;
+    for (;;) {
+      if (k >= n) return NEED_MORE;
+      if (p[k] == 0xFF) break;
+      if (k + 4 > n) return NEED_MORE;
+      bool uniform = p[k] & 0x80;
+      size_t len = p[k + 3];
+      k += 4 + (uniform ? 3 : 3 * len);
+    }
+    used = k + 1;
+    if (!lanes) return SKIP;   // кадры до первого заголовка не с чем связать
+
+    ms = u16(p + 3) | (uint32_t)u16(p + 5) << 16;
+    for (k = 7; p[k] != 0xFF;) {
+      int lane = p[k] & 0x7F;
+      bool uniform = p[k] & 0x80;
+      int start = u16(p + k + 1);
+      int len = p[k + 3];
+      const uint8_t *rgb = p + k + 4;
+      k += 4 + (uniform ? 3 : 3 * len);
+      if (lane >= lanes || start + len > leds) {
+        errors++;
+        continue;
+      }
+      for (int i = 0; i < len; i++) {
+        const uint8_t *c = uniform ? rgb : rgb + 3 * i;
+        frame[lane][start + i] = Pixel{c[0], c[1], c[2]};
+      }
+    }
+    frames++;
+    return FRAME;
+  }
+};
+
+}  // namespace capture
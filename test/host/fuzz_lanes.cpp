@@ -0,0 +1,193 @@
+// Фаззинг игрового цикла случайными нажатиями во времени. Вход — пары
+// байт: кнопка (номер по модулю 2 * NUM_STRIPS, уровень переключается)
+// и пауза до следующего события, 0..1020 мс. Любое INV: — abort().
+// Каждый вход начинается с resetBoard(): кнопки отпущены, матч сброшен
+// в демо, слои перерисованы — без прогона до конца прошлого матча.
+// Живость (после входа все кнопки отпущены, и плата без нажатий обязана
+// вернуться в G_DEMO, иначе abort()) стоит минут виртуального времени на
+// вход, поэтому проверяется на выборке: у входов, чей хеш делится на
+// DRAIN_EVERY, и всегда у входов из файлов. Выборка зависит только от
+// содержимого, упавший вход воспроизводится так же.
+//
+// libFuzzer (clang, HOST_LIBFUZZER=ON): цель fuzz_lanes_libfuzzer, плата
+// загружается один раз, входы идут подряд в одном процессе.
+// Без libFuzzer: fuzz_lanes [файл|- ...] — входы из файлов или stdin
+// (так же её запускает afl-fuzz: afl-fuzz -i in -o out -- fuzz_lanes @@),
+// fuzz_lanes -runs=N [-seed=S] [-max_len=L] [-drain_every=N] — случайные
+// входы. Каждый вход идёт в fork() от загруженной платы, упавший
+// сохраняется в crash-<seed>-<n>.bin и воспроизводится сам по себе.
+// С -in_process случайные входы идут подряд через LLVMFuzzerTestOneInput
+// в одном процессе, как у libFuzzer: так resetBoard() проверяется и там,
+// где clang нет
+#include SKETCH
+#include "host.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace host;
+
+namespace {
+
+// Матч без отбиваний и мигание победителя укладываются с запасом
+constexpr unsigned long DRAIN_LIMIT_MS = 120000;
+
+// DRAIN_EVERY: живость у каждого N-го по хешу входа, 1 — у всех
+unsigned long drainEvery = 16;
+
+void die(const char *what) {
+  fprintf(stderr, "fuzz_lanes: %s (state %d, INV %u, t %lu ms)\n", what, globalState,
+          (unsigned)invariantFaults, millis());
+  for (const std::string &l : lines("INV:")) fprintf(stderr, "  %s\n", l.c_str());
+  abort();
+}
+
+void fuzzTick() {
+  tick();
+  if (invariantFaults) die("нарушен инвариант дорожки");
+  if (globalState > G_GAME_OVER_ANIM) die("неизвестное состояние автомата");
+}
+
+// Плата как после загрузки: всё отпущено, матч кончен, слои сброшены.
+// Миллисекунда после отпускания — опрос видит кнопки поднятыми, и демо
+// не примет их за новое нажатие
+void resetBoard() {
+  for (int s = 0; s < NUM_STRIPS; s++) {
+    release(s, 'L');
+    release(s, 'R');
+  }
+  fuzzTick();
+  anim = Timeline();
+  endMatch();
+  resetAllLanes();
+  fuzzTick();
+  Serial.out.clear();
+}
+
+// FNV-1a входа: выборка для проверки живости
+bool sampledForDrain(const uint8_t *data, size_t size) {
+  uint32_t h = 2166136261u;
+  for (size_t k = 0; k < size; k++) h = (h ^ data[k]) * 16777619u;
+  return drainEvery <= 1 || h % drainEvery == 0;
+}
+
+void runInput(const uint8_t *data, size_t size, bool drain) {
+  resetBoard();
+  for (size_t k = 0; k + 1 < size; k += 2) {
+    int b = data[k] % (2 * NUM_STRIPS);
+    int pin = buttonPin(b / 2, (b & 1) ? 'R' : 'L');
+    setPin(pin, !pins[pin]);
+    for (unsigned ms = data[k + 1] * 4u; ms > 0; ms--) fuzzTick();
+  }
+  if (!drain) return;
+
+  for (int s = 0; s < NUM_STRIPS; s++) {
+    release(s, 'L');
+    release(s, 'R');
+  }
+  const unsigned long until = millis() + DRAIN_LIMIT_MS;
+  while (globalState != G_DEMO) {
+    if (millis() > until) die("без нажатий автомат не вернулся в G_DEMO");
+    fuzzTick();
+  }
+}
+
+bool booted = false;
+
+void bootOnce() {
+  if (booted) return;
+  bootBoard();
+  Serial.out.clear();
+  booted = true;
+}
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  bootOnce();
+  runInput(data, size, sampledForDrain(data, size));
+  return 0;
+}
+
+#ifndef FUZZ_LIBFUZZER
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+
+namespace {
+
+// true — вход прошёл; упавший вход сохраняется, если задано имя
+bool runIsolated(const std::vector<uint8_t> &input, bool drain, const char *saveAs) {
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0) {
+    runInput(input.data(), input.size(), drain);
+    _exit(0);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  if (WIFEXITED(status) && WEXITSTATUS(status) == 0) return true;
+  if (saveAs) {
+    std::ofstream(saveAs, std::ios::binary).write((const char *)input.data(), input.size());
+    fprintf(stderr, "fuzz_lanes: вход сохранён в %s\n", saveAs);
+  }
+  return false;
+}
+
+std::vector<uint8_t> readInput(const char *path) {
+  if (strcmp(path, "-") == 0)
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(std::cin), {});
+  std::ifstream in(path, std::ios::binary);
+  return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), {});
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  unsigned long runs = 0, seed = 1, maxLen = 64;
+  bool inProcess = false;
+  std::vector<const char *> files;
+  for (int k = 1; k < argc; k++) {
+    if (sscanf(argv[k], "-runs=%lu", &runs) == 1) continue;
+    if (sscanf(argv[k], "-seed=%lu", &seed) == 1) continue;
+    if (sscanf(argv[k], "-max_len=%lu", &maxLen) == 1) continue;
+    if (sscanf(argv[k], "-drain_every=%lu", &drainEvery) == 1) continue;
+    if (strcmp(argv[k], "-in_process") == 0) {
+      inProcess = true;
+      continue;
+    }
+    files.push_back(argv[k]);
+  }
+  if (!runs && files.empty()) files.push_back("-");
+
+  bootOnce();
+  int failed = 0;
+  for (const char *f : files)
+    failed += !runIsolated(readInput(f), true, nullptr);
+
+  std::mt19937 rng(seed);
+  unsigned long drained = 0;
+  for (unsigned long n = 0; n < runs; n++) {
+    std::vector<uint8_t> input(rng() % (maxLen + 1));
+    for (uint8_t &b : input) b = rng();
+    // Короткие паузы чаще: дребезг и нажатия внутри одного кадра
+    for (size_t k = 1; k < input.size(); k += 2)
+      if (rng() % 4) input[k] %= 16;
+    char name[64];
+    snprintf(name, sizeof(name), "crash-%lu-%lu.bin", seed, n);
+    const bool drain = sampledForDrain(input.data(), input.size());
+    drained += drain;
+    if (inProcess)
+      LLVMFuzzerTestOneInput(input.data(), input.size());
+    else
+      failed += !runIsolated(input, drain, name);
+  }
+
+  printf("fuzz_lanes: %zu файлов, %lu случайных входов%s (живость у %lu), упало %d\n", files.size(), runs,
+         inProcess ? " в одном процессе" : "", drained, failed);
+  return failed ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,78 @@
+// Помощники тестов. Подключаются после скетча (#include SKETCH), поэтому
+// видят его типы и глобальные переменные
+#pragma once
+#include <cinttypes>
+#include <string>
+#include <vector>
+
+namespace host {
+
+inline int failures = 0;
+
+#define CHECK(cond) \
+  do { if (!(cond)) { host::failures++; printf("%s:%d: CHECK(%s)\n", __FILE__, __LINE__, #cond); } } while (0)
+
+#define CHECK_EQ(a, b) \
+  do { \
+    long long va_ = (long long)(a), vb_ = (long long)(b); \
+    if (va_ != vb_) { host::failures++; printf("%s:%d: %s == %lld, want %lld\n", __FILE__, __LINE__, #a, va_, vb_); } \
+  } while (0)
+
+inline int report(const char *name) {
+  printf("%s: %s\n", name, failures ? "FAIL" : "ok");
+  return failures ? 1 : 0;
+}
+
+// Проход loop() и миллисекунда виртуального времени
+inline void tick() {
+  loop();
+  advance(1000);
+}
+
+inline void run(unsigned long ms) {
+  for (unsigned long k = 0; k < ms; k++) tick();
+}
+
+inline void runUntil(unsigned long ms) {
+  while (millis() < ms) tick();
+}
+
+// Запуск платы до конца отложенных задач (bootTasks)
+inline void bootBoard() {
+  setup();
+  while (!::boot.done) tick();
+}
+
+inline int buttonPin(int lane, char side) {
+  return side == 'L' ? BTN_L[lane] : BTN_R[lane];
+}
+
+inline void hold(int lane, char side)    { setPin(buttonPin(lane, side), LOW); }
+inline void release(int lane, char side) { setPin(buttonPin(lane, side), HIGH); }
+
+inline void press(int lane, char side, unsigned long ms = 60) {
+  hold(lane, side);
+  run(ms);
+  release(lane, side);
+}
+
+// Строки Serial с префиксом, например "SUP:"
+inline std::vector<std::string> lines(const char *prefix) {
+  std::vector<std::string> res;
+  size_t at = 0;
+  const std::string &out = ::Serial.out;
+  while (at < out.size()) {
+    size_t end = out.find('\n', at);
+    if (end == std::string::npos) end = out.size();
+    std::string line = out.substr(at, end - at);
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (line.compare(0, strlen(prefix), prefix) == 0) res.push_back(line);
+    at = end + 1;
+  }
+  return res;
+}
+
+// Пиксель дорожки s в координатах дорожки
+inline CRGB pixel(int s, int i) { return px(s, i); }
+
+}  // namespace host
@@ -0,0 +1,441 @@
+// Сценарии автомата GlobalState на хосте: нажатия по виртуальному
+// времени, ожидаемые состояния, пиксели, узор дорожки и золотые кадры.
+// Плата загружается один раз, каждый сценарий идёт в fork() от этого
+// снимка, поэтому сценарии не видят друг друга.
+//
+//   run_scenarios [--update] [--golden файл] файл.scn|каталог ...
+//
+// Формат .scn (время в мс от начала сценария, строки с # в начале — комментарии):
+//   scenario <имя>
+//   vary <переменная> <от> <до> <шаг>   размножить сценарий, $переменная в строках
+//   <мс> press <дорожка> L|R [удержание]
+//   <мс> down|up <дорожка> L|R
+//   <мс> state DEMO|START_FILL|PLAYING|GAME_OVER_ANIM
+//   <мс> score <дорожка> <левый> <правый>  выставить счёт
+//   <мс> pixel <дорожка> <i> <RRGGBB>
+//   <мс> lane <дорожка> <узор>          RLE по слотам: . фон, L, R, B шарик, # препятствие, ? любой
+//   <мс> golden                         хеш leds[][] против golden/scenarios.txt
+//   end
+#include SKETCH
+#include "host.h"
+
+#include <chrono>
+#include <cstdarg>
+#include <dirent.h>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace host;
+
+namespace {
+
+struct Step {
+  unsigned long ms;
+  std::string op;
+  std::vector<std::string> args;
+  int line;
+};
+
+struct Scenario {
+  std::string name;
+  std::string file;
+  int group;        // варианты одного vary — одна группа
+  std::vector<Step> steps;
+};
+
+int groups = 0;
+
+std::vector<std::string> words(const std::string &s) {
+  std::istringstream in(s);
+  std::vector<std::string> w;
+  for (std::string x; in >> x;) w.push_back(x);
+  return w;
+}
+
+std::string substitute(std::string s, const std::string &var, long v) {
+  const std::string key = "$" + var;
+  for (size_t at; (at = s.find(key)) != std::string::npos;)
+    s.replace(at, key.size(), std::to_string(v));
+  return s;
+}
+
+// Арифметика во времени: "2500+$t" после подстановки
+unsigned long parseMs(const std::string &s) {
+  unsigned long sum = 0;
+  std::istringstream in(s);
+  std::string part;
+  while (std::getline(in, part, '+')) sum += strtoul(part.c_str(), nullptr, 10);
+  return sum;
+}
+
+bool parseBody(const std::string &file, const std::string &name,
+               const std::vector<std::pair<int, std::string>> &body,
+               const std::string &var, long v, std::vector<Scenario> &out) {
+  Scenario sc;
+  sc.name = var.empty() ? name : name + " " + var + "=" + std::to_string(v);
+  sc.file = file;
+  sc.group = groups;
+  for (const auto &ln : body) {
+    std::vector<std::string> w = words(var.empty() ? ln.second : substitute(ln.second, var, v));
+    if (w.size() < 2) {
+      fprintf(stderr, "%s:%d: ожидалось '<мс> <действие> ...'\n", file.c_str(), ln.first);
+      return false;
+    }
+    Step st{parseMs(w[0]), w[1], std::vector<std::string>(w.begin() + 2, w.end()), ln.first};
+    if (st.op == "press") {
+      // нажатие = down и up через удержание (по умолчанию 60 мс)
+      unsigned long holdMs = st.args.size() > 2 ? strtoul(st.args[2].c_str(), nullptr, 10) : 60;
+      st.args.resize(2);
+      st.op = "down";
+      sc.steps.push_back(st);
+      st.op = "up";
+      st.ms += holdMs;
+    }
+    sc.steps.push_back(st);
+  }
+  std::stable_sort(sc.steps.begin(), sc.steps.end(),
+                   [](const Step &a, const Step &b) { return a.ms < b.ms; });
+  out.push_back(sc);
+  return true;
+}
+
+bool parseFile(const std::string &file, std::vector<Scenario> &out) {
+  std::ifstream in(file);
+  if (!in) {
+    fprintf(stderr, "%s: не открывается\n", file.c_str());
+    return false;
+  }
+  std::string name, var;
+  long from = 0, to = 0, step = 1;
+  std::vector<std::pair<int, std::string>> body;
+  bool open = false;
+  int n = 0;
+  for (std::string line; std::getline(in, line);) {
+    n++;
+    std::vector<std::string> w = words(line);
+    if (w.empty() || w[0][0] == '#') continue;
+    if (w[0] == "scenario") {
+      name = w.size() > 1 ? w[1] : "?";
+      var.clear();
+      body.clear();
+      open = true;
+    } else if (w[0] == "vary" && w.size() == 5) {
+      var = w[1];
+      from = strtol(w[2].c_str(), nullptr, 10);
+      to = strtol(w[3].c_str(), nullptr, 10);
+      step = max(1L, strtol(w[4].c_str(), nullptr, 10));
+    } else if (w[0] == "end") {
+      if (!open) {
+        fprintf(stderr, "%s:%d: end без scenario\n", file.c_str(), n);
+        return false;
+      }
+      groups++;
+      if (var.empty()) {
+        if (!parseBody(file, name, body, var, 0, out)) return false;
+      } else {
+        for (long v = from; v <= to; v += step)
+          if (!parseBody(file, name, body, var, v, out)) return false;
+      }
+      open = false;
+    } else if (open) {
+      body.push_back({n, line});
+    } else {
+      fprintf(stderr, "%s:%d: строка вне scenario\n", file.c_str(), n);
+      return false;
+    }
+  }
+  return !open;
+}
+
+bool collect(const std::string &path, std::vector<Scenario> &out) {
+  DIR *d = opendir(path.c_str());
+  if (!d) return parseFile(path, out);
+  std::vector<std::string> files;
+  while (dirent *e = readdir(d)) {
+    std::string f = e->d_name;
+    if (f.size() > 4 && f.compare(f.size() - 4, 4, ".scn") == 0) files.push_back(path + "/" + f);
+  }
+  closedir(d);
+  std::sort(files.begin(), files.end());
+  bool ok = true;
+  for (const std::string &f : files) ok &= parseFile(f, out);
+  return ok;
+}
+
+// ----- выполнение в дочернем процессе -----
+//
+// Дочерние процессы пишут в общий канал строки с табуляцией:
+//   F <сценарий> <сообщение>       несовпадение
+//   G <сценарий> <мс> <хеш> <где>  золотой кадр
+//   X <сценарий> <сигнал>          процесс упал
+
+int outFd = -1;
+const Scenario *cur = nullptr;
+bool curFailed = false;
+
+void fail(const Step &st, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+void fail(const Step &st, const char *fmt, ...) {
+  char msg[256];
+  va_list ap;
+  va_start(ap, fmt);
+  vsnprintf(msg, sizeof(msg), fmt, ap);
+  va_end(ap);
+  dprintf(outFd, "F\t%s\t%s:%d: %lu %s: %s\n", cur->name.c_str(), cur->file.c_str(), st.line,
+          st.ms, st.op.c_str(), msg);
+  curFailed = true;
+}
+
+int laneArg(const Step &st, size_t k) {
+  int lane = k < st.args.size() ? atoi(st.args[k].c_str()) : -1;
+  if (lane < 0 || lane >= NUM_STRIPS) {
+    fail(st, "нет дорожки");
+    return -1;
+  }
+  return lane;
+}
+
+int stateByName(const std::string &s) {
+  static const char *const NAMES[] = { "DEMO", "START_FILL", "PLAYING", "GAME_OVER_ANIM" };
+  for (int k = 0; k < 4; k++)
+    if (s == NAMES[k]) return k;
+  return -1;
+}
+
+// Узор "10L 86. 2? 10R": число и символ слота, без числа — один пиксель
+bool matchLane(const Step &st, int lane, const std::string &pattern) {
+  const CRGB *pal = laneColors[lane];
+  int i = 0;
+  for (size_t k = 0; k < pattern.size();) {
+    if (isspace((unsigned char)pattern[k])) { k++; continue; }
+    int count = 0;
+    bool hasCount = false;
+    while (k < pattern.size() && isdigit((unsigned char)pattern[k])) {
+      count = count * 10 + (pattern[k++] - '0');
+      hasCount = true;
+    }
+    if (k == pattern.size()) break;
+    char sym = pattern[k++];
+    if (!hasCount) count = 1;
+    for (int n = 0; n < count; n++, i++) {
+      if (i >= NUM_LEDS) {
+        fail(st, "узор длиннее дорожки");
+        return false;
+      }
+      CRGB want;
+      switch (sym) {
+        case '?': continue;
+        case '.': want = pal[PAL_BG]; break;
+        case 'L': want = pal[PAL_LEFT]; break;
+        case 'R': want = pal[PAL_RIGHT]; break;
+        case 'B': want = pal[PAL_BALL]; break;
+        case '#': want = pal[PAL_OBSTACLE]; break;
+        default: fail(st, "символ узора '%c'", sym); return false;
+      }
+      CRGB got = pixel(lane, i);
+      if (got != want) {
+        fail(st, "пиксель %d: %02x%02x%02x, ожидался '%c' %02x%02x%02x", i,
+             got.r, got.g, got.b, sym, want.r, want.g, want.b);
+        return false;
+      }
+    }
+  }
+  if (i != NUM_LEDS) fail(st, "узор на %d пикселей, в дорожке %d", i, NUM_LEDS);
+  return i == NUM_LEDS;
+}
+
+void exec(const Step &st) {
+  if (st.op == "down" || st.op == "up") {
+    int lane = laneArg(st, 0);
+    if (lane < 0) return;
+    char side = st.args.size() > 1 ? st.args[1][0] : '?';
+    if (side != 'L' && side != 'R') return fail(st, "сторона L или R");
+    setPin(buttonPin(lane, side), st.op == "down" ? LOW : HIGH);
+  } else if (st.op == "state") {
+    int want = st.args.empty() ? -1 : stateByName(st.args[0]);
+    if (want < 0) return fail(st, "неизвестное состояние");
+    if (globalState != want) fail(st, "состояние %d, ожидалось %s", globalState, st.args[0].c_str());
+  } else if (st.op == "score") {
+    int lane = laneArg(st, 0);
+    if (lane < 0 || st.args.size() < 3) return;
+    game[lane].scoreL = atoi(st.args[1].c_str());
+    game[lane].scoreR = atoi(st.args[2].c_str());
+    updateZones<GAME_MODE>(game[lane]);
+  } else if (st.op == "pixel") {
+    int lane = laneArg(st, 0);
+    if (lane < 0 || st.args.size() < 3) return;
+    int i = atoi(st.args[1].c_str());
+    CRGB want(strtoul(st.args[2].c_str(), nullptr, 16));
+    CRGB got = pixel(lane, i);
+    if (got != want) fail(st, "пиксель %d: %02x%02x%02x", i, got.r, got.g, got.b);
+  } else if (st.op == "lane") {
+    int lane = laneArg(st, 0);
+    if (lane < 0) return;
+    std::string pattern;
+    for (size_t k = 1; k < st.args.size(); k++) pattern += st.args[k];
+    matchLane(st, lane, pattern);
+  } else if (st.op == "golden") {
+    uint64_t h = frameHash64((const uint8_t *)leds, sizeof(leds));
+    dprintf(outFd, "G\t%s\t%lu\t%016llx\t%s:%d\n", cur->name.c_str(), st.ms,
+            (unsigned long long)h, cur->file.c_str(), st.line);
+  } else {
+    fail(st, "неизвестное действие");
+  }
+}
+
+void runSteps(const Scenario &sc, unsigned long start, size_t from, size_t to) {
+  cur = &sc;
+  for (size_t k = from; k < to; k++) {
+    runUntil(start + sc.steps[k].ms);
+    exec(sc.steps[k]);
+  }
+}
+
+// Сценарии одного vary [first, last) с общими первыми shared шагами:
+// общая часть проходится один раз, от неё — fork() на каждый вариант
+void runGroup(const Scenario *first, const Scenario *last, size_t shared) {
+  const unsigned long start = millis();
+  runSteps(*first, start, 0, shared);
+  bool prefixFailed = curFailed;
+
+  for (const Scenario *sc = first; sc != last; sc++) {
+    pid_t pid = fork();
+    if (pid == 0) {
+      runSteps(*sc, start, shared, sc->steps.size());
+      if (invariantFaults)
+        dprintf(outFd, "F\t%s\t%s: нарушено инвариантов дорожек: %u\n", sc->name.c_str(),
+                sc->file.c_str(), (unsigned)invariantFaults);
+      _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status)) dprintf(outFd, "X\t%s\t%d\n", sc->name.c_str(), WTERMSIG(status));
+    if (prefixFailed && sc != first) dprintf(outFd, "F\t%s\tобщая часть не прошла\n", sc->name.c_str());
+  }
+  _exit(0);
+}
+
+size_t commonSteps(const Scenario &a, const Scenario &b) {
+  size_t n = 0;
+  while (n < a.steps.size() && n < b.steps.size() && a.steps[n].ms == b.steps[n].ms &&
+         a.steps[n].op == b.steps[n].op && a.steps[n].args == b.steps[n].args)
+    n++;
+  return n;
+}
+
+std::vector<std::string> split(const std::string &s, char sep) {
+  std::vector<std::string> parts;
+  std::istringstream in(s);
+  for (std::string p; std::getline(in, p, sep);) parts.push_back(p);
+  return parts;
+}
+
+// ----- золотые кадры -----
+
+std::map<std::string, std::string> loadGolden(const std::string &file) {
+  std::map<std::string, std::string> g;
+  std::ifstream in(file);
+  for (std::string line; std::getline(in, line);) {
+    if (line.empty() || line[0] == '#') continue;
+    size_t sp = line.rfind(' ');
+    if (sp != std::string::npos) g[line.substr(0, sp)] = line.substr(sp + 1);
+  }
+  return g;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  bool update = false;
+  std::string goldenFile = std::string(GOLDEN_DIR) + "/scenarios.txt";
+  std::vector<Scenario> all;
+  bool ok = true;
+  for (int k = 1; k < argc; k++) {
+    std::string a = argv[k];
+    if (a == "--update") update = true;
+    else if (a == "--golden" && k + 1 < argc) goldenFile = argv[++k];
+    else ok &= collect(a, all);
+  }
+  if (!ok || all.empty()) {
+    fprintf(stderr, "run_scenarios: нет сценариев\n");
+    return 2;
+  }
+
+  bootBoard();
+  Serial.out.clear();
+  fflush(stdout);
+
+  std::map<std::string, std::string> golden = loadGolden(goldenFile);
+  std::map<std::string, std::string> seen;
+  auto t0 = std::chrono::steady_clock::now();
+
+  std::set<std::string> bad;
+  for (size_t k = 0; k < all.size();) {
+    size_t end = k + 1, shared = all[k].steps.size();
+    while (end < all.size() && all[end].group == all[k].group) {
+      shared = min(shared, commonSteps(all[k], all[end]));
+      end++;
+    }
+    if (end - k == 1) shared = 0;
+
+    int fds[2];
+    if (pipe(fds) != 0) return 2;
+    pid_t pid = fork();
+    if (pid == 0) {
+      close(fds[0]);
+      outFd = fds[1];
+      runGroup(&all[k], &all[0] + end, shared);
+    }
+    close(fds[1]);
+    std::string out;
+    char buf[4096];
+    for (ssize_t n; (n = read(fds[0], buf, sizeof(buf))) > 0;) out.append(buf, n);
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status)) {
+      printf("%s: группа упала, сигнал %d\n", all[k].file.c_str(), WTERMSIG(status));
+      for (size_t n = k; n < end; n++) bad.insert(all[n].name);
+    }
+
+    std::istringstream lines(out);
+    for (std::string line; std::getline(lines, line);) {
+      std::vector<std::string> f = split(line, '\t');
+      if (f[0] == "F" && f.size() == 3) {
+        printf("[%s] %s\n", f[1].c_str(), f[2].c_str());
+        bad.insert(f[1]);
+      } else if (f[0] == "X" && f.size() == 3) {
+        printf("[%s] упал, сигнал %s\n", f[1].c_str(), f[2].c_str());
+        bad.insert(f[1]);
+      } else if (f[0] == "G" && f.size() == 5) {
+        const std::string key = f[1] + "@" + f[2], &hash = f[3];
+        seen[key] = hash;
+        if (update) continue;
+        auto g = golden.find(key);
+        if (g == golden.end()) {
+          printf("%s: [%s] нет золотого кадра, запустите с --update\n", f[4].c_str(), key.c_str());
+          bad.insert(f[1]);
+        } else if (g->second != hash) {
+          printf("%s: [%s] кадр %s, золотой %s\n", f[4].c_str(), key.c_str(), hash.c_str(), g->second.c_str());
+          bad.insert(f[1]);
+        }
+      }
+    }
+    k = end;
+  }
+  const size_t failed = bad.size();
+
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+  printf("scenarios: %zu, failed %zu, %.1f ms, %.0f/s\n", all.size(), failed, ms, all.size() * 1000.0 / ms);
+
+  if (update) {
+    std::ofstream out(goldenFile);
+    out << "# хеши leds[][] в точках golden сценариев; обновление: run_scenarios --update\n";
+    for (const auto &kv : seen) out << kv.first << ' ' << kv.second << '\n';
+    printf("golden: %zu кадров записано в %s\n", seen.size(), goldenFile.c_str());
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,339 @@
+// Определения хост-шима: часы, пины, Serial, контроллеры FastLED,
+// EEPROM, SPI и модель MCP23017
+#include <FastLED.h>
+#include <EEPROM.h>
+#include <SPI.h>
+#include <Wire.h>
+#include <esp_sleep.h>
+#include <esp_task_wdt.h>
+
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace host {
+
+uint64_t nowUs = 0;
+bool realtime = false;
+double clockRate = 1.0;
+int64_t clockOffsetUs = 0;
+
+static uint64_t monotonicUs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+uint64_t clockUs() {
+  if (!realtime) return nowUs;
+  static const uint64_t start = monotonicUs();
+  return (uint64_t)((double)(monotonicUs() - start) * clockRate) + clockOffsetUs;
+}
+
+uint8_t pins[PINS];
+uint8_t pinModes[PINS];
+void (*isr[PINS])();
+int isrMode[PINS];
+int8_t wakeLevel[PINS];
+
+struct PinsInit {
+  PinsInit() {
+    memset(pins, HIGH, sizeof(pins));
+    memset(wakeLevel, -1, sizeof(wakeLevel));
+  }
+} pinsInit;
+
+struct PinEdge {
+  uint64_t us;
+  int pin;
+  int level;
+};
+
+static std::vector<PinEdge> pinEdges;
+
+void setPinAt(uint64_t atUs, int pin, int level) {
+  pinEdges.push_back(PinEdge{ atUs, pin, level });
+}
+
+static void applyPinEdges() {
+  for (size_t k = 0; k < pinEdges.size();) {
+    if (pinEdges[k].us > nowUs) {
+      k++;
+      continue;
+    }
+    const PinEdge e = pinEdges[k];
+    pinEdges.erase(pinEdges.begin() + k);
+    setPin(e.pin, e.level);
+  }
+}
+
+void advance(uint64_t us) {
+  if (realtime) {
+    usleep(us);
+    return;
+  }
+  nowUs += us;
+  applyPinEdges();
+}
+
+void setPin(int pin, int level) {
+  int was = pins[pin];
+  pins[pin] = level ? HIGH : LOW;
+  if (!isr[pin] || was == pins[pin]) return;
+  bool fall = was && !level;
+  if (isrMode[pin] == CHANGE || (isrMode[pin] == FALLING && fall) || (isrMode[pin] == RISING && !fall))
+    isr[pin]();
+}
+
+int tones = 0;
+std::vector<ToneEdge> toneLog;
+
+void toneEdge(unsigned freq) {
+  toneLog.push_back(ToneEdge{ clockUs(), (uint16_t)freq });
+}
+
+static void put16(FILE *f, uint16_t v) { fputc(v & 0xFF, f); fputc(v >> 8, f); }
+static void put32(FILE *f, uint32_t v) { put16(f, v & 0xFFFF); put16(f, v >> 16); }
+
+// От начала журнала до последней смены и ещё 100 мс
+bool writeWav(const char *path, unsigned rate) {
+  FILE *f = fopen(path, "wb");
+  if (!f) return false;
+  const uint64_t start = toneLog.empty() ? 0 : toneLog.front().us;
+  const uint64_t end = toneLog.empty() ? start : toneLog.back().us + 100000;
+  const uint32_t samples = (uint32_t)((end - start) * rate / 1000000);
+
+  fwrite("RIFF", 1, 4, f);
+  put32(f, 36 + samples * 2);
+  fwrite("WAVEfmt ", 1, 8, f);
+  put32(f, 16);
+  put16(f, 1);   // PCM
+  put16(f, 1);   // моно
+  put32(f, rate);
+  put32(f, rate * 2);
+  put16(f, 2);
+  put16(f, 16);
+  fwrite("data", 1, 4, f);
+  put32(f, samples * 2);
+
+  size_t edge = 0;
+  unsigned freq = 0;
+  double phase = 0;
+  for (uint32_t n = 0; n < samples; n++) {
+    const uint64_t us = start + (uint64_t)n * 1000000 / rate;
+    while (edge < toneLog.size() && toneLog[edge].us <= us) {
+      if (toneLog[edge].freq != freq) phase = 0;
+      freq = toneLog[edge++].freq;
+    }
+    int16_t v = 0;
+    if (freq) {
+      v = phase < 0.5 ? 8000 : -8000;
+      phase += (double)freq / rate;
+      phase -= (int)phase;
+    }
+    put16(f, (uint16_t)v);
+  }
+  return fclose(f) == 0;
+}
+int sleeps = 0;
+uint64_t sleptUs = 0;
+uint64_t wakeAfterUs = 0;
+bool gpioWake = false;
+
+// Будящий уровень уже на пине — сон кончается сразу
+uint64_t sleepUs(uint64_t timerUs) {
+  if (!gpioWake) return timerUs;
+  for (int pin = 0; pin < PINS; pin++)
+    if (wakeLevel[pin] == pins[pin]) return 0;
+  for (const PinEdge &e : pinEdges)
+    if (wakeLevel[e.pin] == e.level && e.us < nowUs + timerUs) timerUs = e.us > nowUs ? e.us - nowUs : 0;
+  return timerUs;
+}
+int wdtFeeds = 0;
+bool wdtRunning = true;
+uint32_t wdtTimeoutMs = 5000;
+esp_err_t wdtAddErr = ESP_OK;
+
+Controller ctrls[MAX_CTRL];
+int ctrlCount = 0;
+int shows = 0;
+int ctrlShows = 0;
+bool modelWire = false;
+uint64_t showCostUs = 0;
+void (*onShow)() = nullptr;
+
+Mcp23017 mcp[8];
+
+// Бинарный дизеринг FastLED (init_binary_dithering/stepDithering): к
+// ненулевому каналу перед масштабированием добавляется поправка, которая
+// чередуется от кадра к кадру и от пикселя к пикселю, поэтому средняя
+// яркость точнее, чем у одного scale8
+static uint8_t ditherFrame = 0;
+
+void transmit(int c, uint8_t brightness, uint8_t dither) {
+  Controller &k = ctrls[c];
+  uint8_t e = 0, d = 0;
+  if (dither && brightness) {
+    uint8_t q = (ditherFrame & 1) ? 0x80 : 0;
+    e = 256 / brightness + 1;
+    d = scale8(q, e);
+    e--;
+  }
+  k.wire.resize(k.n * 3);
+  for (int i = 0; i < k.n; i++) {
+    d = e - d;
+    for (int ch = 0; ch < 3; ch++) {
+      uint8_t v = k.data[i].raw[ch];
+      if (v) v = qadd8(v, d);
+      k.wire[i * 3 + ch] = (char)scale8(v, brightness);
+    }
+  }
+  k.shows++;
+}
+
+static uint64_t wireTimeUs(int c) {
+  return (uint64_t)ctrls[c].n * ctrls[c].wireNsPerLed / 1000 + 50;
+}
+
+void show(uint8_t brightness, uint8_t dither) {
+  ditherFrame++;
+  uint64_t longest = 0;
+  for (int c = 0; c < ctrlCount; c++) {
+    transmit(c, brightness, dither);
+    longest = std::max(longest, wireTimeUs(c));
+  }
+  shows++;
+  if (modelWire) advance(longest);
+  if (showCostUs) advance(showCostUs);
+  if (onShow) onShow();
+}
+
+}  // namespace host
+
+void CLEDController::showLeds(uint8_t brightness) {
+  host::transmit(index, brightness, dither & FastLED.dither);
+  host::ctrlShows++;
+  if (host::modelWire) host::advance(host::wireTimeUs(index));
+  if (host::showCostUs) host::advance(host::showCostUs / host::ctrlCount);
+}
+
+CLEDController &CFastLED::add(CRGB *data, int n, int dataPin, int clockPin, uint32_t nsPerLed) {
+  int c = host::ctrlCount++;
+  host::Controller &k = host::ctrls[c];
+  k.data = data;
+  k.n = n;
+  k.dataPin = dataPin;
+  k.clockPin = clockPin;
+  k.wireNsPerLed = nsPerLed;
+  return ctrl[c];
+}
+
+void CFastLED::clear(bool write) {
+  for (int c = 0; c < host::ctrlCount; c++) fill_solid(host::ctrls[c].data, host::ctrls[c].n, CRGB::Black);
+  if (write) show();
+}
+
+CFastLED FastLED;
+
+/* ----- Serial ----- */
+
+HardwareSerial Serial(0);
+HardwareSerial Serial1(1);
+HardwareSerial Serial2(2);
+
+int HardwareSerial::available() {
+  if (fd >= 0) {
+    uint8_t buf[256];
+    ssize_t n = ::read(fd, buf, sizeof(buf));
+    for (ssize_t i = 0; i < n; i++) in.push_back(buf[i]);
+  }
+  return (int)in.size();
+}
+
+int HardwareSerial::read() {
+  if (in.empty() && !available()) return -1;
+  int c = in.front();
+  in.pop_front();
+  return c;
+}
+
+size_t HardwareSerial::write(const uint8_t *p, size_t n) {
+  if (fd >= 0) {
+    size_t done = 0;
+    while (done < n) {
+      ssize_t k = ::write(fd, p + done, n - done);
+      if (k > 0) done += k;
+      else usleep(100);
+    }
+    return n;
+  }
+  out.append((const char *)p, n);
+  if (echo) fwrite(p, 1, n, stdout);
+  return n;
+}
+
+size_t HardwareSerial::print(long v, int base) {
+  if (v < 0 && base == DEC) return print('-') + print((unsigned long)-v, base);
+  return print((unsigned long)v, base);
+}
+
+size_t HardwareSerial::print(unsigned long v, int base) {
+  char buf[24];
+  int n = 0;
+  do {
+    buf[n++] = "0123456789ABCDEF"[v % base];
+    v /= base;
+  } while (v);
+  std::string s(buf, n);
+  std::reverse(s.begin(), s.end());
+  return print(s);
+}
+
+size_t HardwareSerial::print(double v, int digits) {
+  char buf[48];
+  snprintf(buf, sizeof(buf), "%.*f", digits, v);
+  return print(buf);
+}
+
+/* ----- EEPROM, SPI, I2C ----- */
+
+EEPROMClass EEPROM;
+SPIClass SPI;
+TwoWire Wire;
+
+namespace host {
+
+bool modelBus = false;
+
+void busBits(uint32_t bits, uint32_t hz) {
+  if (modelBus && hz) advance(((uint64_t)bits * 1000000 + hz - 1) / hz);
+}
+
+}  // namespace host
+
+uint8_t TwoWire::endTransmission(bool) {
+  host::busBits(9 * (1 + txLen) + 2, clock);
+  if (target < 0x20 || target > 0x27 || !host::mcp[target - 0x20].present) return 2;   // NACK адреса
+  host::Mcp23017 &m = host::mcp[target - 0x20];
+  if (txLen == 0) return 0;
+  m.pointer = tx[0];
+  for (size_t i = 1; i < txLen; i++) {
+    if (m.pointer < sizeof(m.reg)) m.reg[m.pointer] = tx[i];
+    m.pointer++;
+  }
+  return 0;
+}
+
+uint8_t TwoWire::requestFrom(int addr, int n, bool) {
+  rxLen = rxPos = 0;
+  host::busBits(9 * (1 + n) + 2, clock);
+  if (addr < 0x20 || addr > 0x27 || !host::mcp[addr - 0x20].present) return 0;
+  host::Mcp23017 &m = host::mcp[addr - 0x20];
+  for (int i = 0; i < n && rxLen < (int)sizeof(rx); i++, m.pointer++) {
+    uint8_t v = m.pointer < sizeof(m.reg) ? m.reg[m.pointer] : 0;
+    if (m.pointer == 0x12) v = m.inputs[0];   // GPIOA
+    if (m.pointer == 0x13) v = m.inputs[1];   // GPIOB
+    rx[rxLen++] = v;
+  }
+  return rxLen;
+}
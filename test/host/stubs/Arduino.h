@@ -0,0 +1,178 @@
+// Хост-шим Arduino/ESP32 для проверок скетча на ПК. Время виртуальное
+// (host::advance) или настоящее (host::realtime, платы test_shards),
+// пины — массив уровней с прерываниями по фронту, Serial пишет в буфер.
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+#ifndef HOST_NO_ESP32
+#define ESP32 1
+#endif
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define PROGMEM
+#define IRAM_ATTR
+#define INPUT        0x01
+#define OUTPUT       0x03
+#define INPUT_PULLUP 0x05
+#define LOW     0
+#define HIGH    1
+#define RISING  1
+#define FALLING 2
+#define CHANGE  3
+#define DEC 10
+#define HEX 16
+
+#define SERIAL_8N1 0x800001c
+
+inline uint8_t  pgm_read_byte(const void *p)  { return *(const uint8_t *)p; }
+inline uint16_t pgm_read_word(const void *p)  { uint16_t v; memcpy(&v, p, 2); return v; }
+inline uint32_t pgm_read_dword(const void *p) { uint32_t v; memcpy(&v, p, 4); return v; }
+
+using std::max;
+using std::min;
+
+template <class T, class L, class H>
+T constrain(T x, L lo, H hi) { return x < lo ? lo : (x > hi ? hi : x); }
+
+namespace host {
+
+constexpr int PINS = 64;
+
+extern uint64_t nowUs;            // виртуальные часы
+extern bool realtime;             // часы от CLOCK_MONOTONIC
+extern double clockRate;          // ход часов платы относительно настоящих
+extern int64_t clockOffsetUs;
+
+uint64_t clockUs();
+void advance(uint64_t us);
+
+extern uint8_t pins[PINS];
+extern uint8_t pinModes[PINS];
+extern void (*isr[PINS])();
+extern int isrMode[PINS];
+void setPin(int pin, int level);  // внешний уровень, с прерыванием по фронту
+// Смена уровня в момент atUs: advance() применяет её, дойдя до него,
+// а light sleep по ней просыпается, если пин будит этим уровнем
+void setPinAt(uint64_t atUs, int pin, int level);
+extern int8_t wakeLevel[PINS];    // gpio_wakeup_enable, -1 — не будит
+
+extern int tones;
+
+// Звуковой бэкенд хоста: каждый tone()/noTone() с временем платы.
+// writeWav() сводит журнал в меандр, моно 16 бит, для прослушивания и
+// сверки звука с кадрами
+struct ToneEdge {
+  uint64_t us;
+  uint16_t freq;   // 0 — тишина
+};
+extern std::vector<ToneEdge> toneLog;
+void toneEdge(unsigned freq);
+bool writeWav(const char *path, unsigned rate = 16000);
+
+extern int sleeps;
+extern uint64_t sleptUs;
+
+// SPI и I2C занимают время своих битов на шине (SPISettings / setClock)
+extern bool modelBus;
+void busBits(uint32_t bits, uint32_t hz);
+
+}  // namespace host
+
+inline unsigned long micros() { return (unsigned long)host::clockUs(); }
+inline unsigned long millis() { return (unsigned long)(host::clockUs() / 1000); }
+inline void delay(unsigned long ms) { host::advance((uint64_t)ms * 1000); }
+inline void delayMicroseconds(unsigned int us) { host::advance(us); }
+
+inline void pinMode(uint8_t pin, uint8_t mode) {
+  host::pinModes[pin] = mode;
+  if (mode == INPUT_PULLUP) host::pins[pin] = HIGH;
+}
+inline int digitalRead(uint8_t pin) { return host::pins[pin]; }
+inline void digitalWrite(uint8_t pin, uint8_t v) { host::pins[pin] = v ? HIGH : LOW; }
+inline int analogRead(uint8_t) { return 0; }
+
+inline int digitalPinToInterrupt(int pin) { return pin; }
+inline void attachInterrupt(int pin, void (*fn)(), int mode) {
+  host::isr[pin] = fn;
+  host::isrMode[pin] = mode;
+}
+inline void detachInterrupt(int pin) { host::isr[pin] = nullptr; }
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+inline long random(long lo, long hi) { return hi > lo ? lo + rand() % (hi - lo) : lo; }
+inline long random(long hi) { return random(0, hi); }
+inline void randomSeed(unsigned long s) { srand(s); }
+
+inline void tone(uint8_t, unsigned int freq) {
+  host::tones++;
+  host::toneEdge(freq);
+}
+inline void noTone(uint8_t) { host::toneEdge(0); }
+
+// FreeRTOS: задачи на хосте не запускаются, проигрыватель звука
+// опрашивается тестом сам
+typedef void *TaskHandle_t;
+inline int xTaskCreatePinnedToCore(void (*)(void *), const char *, uint32_t, void *, int, TaskHandle_t *, int) { return 1; }
+inline void vTaskDelay(uint32_t) {}
+
+class HardwareSerial {
+public:
+  explicit HardwareSerial(int port) : port(port) {}
+
+  void begin(unsigned long b) { baud = b; }
+  void begin(unsigned long b, uint32_t, int8_t rx, int8_t tx) { baud = b; rxPin = rx; txPin = tx; }
+  void end() {}
+  void setTxBufferSize(size_t n) { txBuffer = n; }
+  int availableForWrite() { return (int)txBuffer; }
+  void flush() {}
+  operator bool() const { return true; }
+
+  int available();
+  int read();
+  size_t write(uint8_t c) { return write(&c, 1); }
+  size_t write(const uint8_t *p, size_t n);
+  size_t write(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+
+  size_t print(const char *s) { return write(s); }
+  size_t print(const std::string &s) { return write(s.c_str()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int v, int base = DEC) { return print((long)v, base); }
+  size_t print(unsigned v, int base = DEC) { return print((unsigned long)v, base); }
+  size_t print(long v, int base = DEC);
+  size_t print(unsigned long v, int base = DEC);
+  size_t print(long long v, int base = DEC) { return print((long)v, base); }
+  size_t print(unsigned long long v, int base = DEC) { return print((unsigned long)v, base); }
+  size_t print(double v, int digits = 2);
+
+  template <class T> size_t println(T v) { size_t n = print(v); return n + println(); }
+  template <class T> size_t println(T v, int arg) { size_t n = print(v, arg); return n + println(); }
+  size_t println() { return write("\r\n"); }
+
+  // хост
+  int port;
+  unsigned long baud = 0;
+  int rxPin = -1, txPin = -1;
+  size_t txBuffer = 128;
+  std::string out;              // всё, что скетч записал
+  std::deque<uint8_t> in;       // что скетч прочитает
+  int fd = -1;                  // Serial2 плат test_shards: байты идут в fd
+  bool echo = false;            // дублировать вывод в stdout
+
+  void feed(const char *s) { while (*s) in.push_back((uint8_t)*s++); }
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+extern HardwareSerial Serial2;
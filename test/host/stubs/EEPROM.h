@@ -0,0 +1,20 @@
+// Хост-шим EEPROM: стёртая флеш-эмуляция, commit() считается
+#pragma once
+#include "Arduino.h"
+
+class EEPROMClass {
+public:
+  EEPROMClass() { memset(mem, 0xFF, sizeof(mem)); }
+  bool begin(size_t n) { size = n; return n <= sizeof(mem); }
+  bool commit() { commits++; return true; }
+  uint8_t read(int addr) { return mem[addr]; }
+  void write(int addr, uint8_t v) { mem[addr] = v; }
+  template <class T> T &get(int addr, T &t) { memcpy(&t, mem + addr, sizeof(T)); return t; }
+  template <class T> const T &put(int addr, const T &t) { memcpy(mem + addr, &t, sizeof(T)); return t; }
+
+  uint8_t mem[4096];
+  size_t size = 0;
+  int commits = 0;
+};
+
+extern EEPROMClass EEPROM;
@@ -0,0 +1,166 @@
+// Хост-шим FastLED: CRGB и математика 8 бит в объёме скетча, контроллеры
+// без железа. show() считает то, что ушло бы в провод (яркость и
+// бинарный дизеринг как в FastLED), и двигает виртуальное время на
+// модельное время передачи
+#pragma once
+#include "Arduino.h"
+
+inline uint8_t scale8(uint8_t i, uint8_t s) { return ((uint16_t)i * (1 + (uint16_t)s)) >> 8; }
+inline uint8_t scale8_video(uint8_t i, uint8_t s) { return (((uint16_t)i * s) >> 8) + ((i && s) ? 1 : 0); }
+inline uint8_t qadd8(uint8_t a, uint8_t b) { int t = a + b; return t > 255 ? 255 : t; }
+inline uint8_t qsub8(uint8_t a, uint8_t b) { int t = a - b; return t < 0 ? 0 : t; }
+inline uint8_t lerp8by8(uint8_t a, uint8_t b, uint8_t f) { return b > a ? a + scale8(b - a, f) : a - scale8(a - b, f); }
+inline uint8_t dim8_raw(uint8_t x) { return scale8(x, x); }
+
+// Таблица синуса как в FastLED (sin8_C)
+inline uint8_t sin8(uint8_t theta) {
+  static const uint8_t b_m16_interleave[] = { 0, 49, 49, 41, 90, 27, 117, 10 };
+  uint8_t offset = theta;
+  if (theta & 0x40) offset = (uint8_t)255 - offset;
+  offset &= 0x3F;
+  uint8_t secoffset = offset & 0x0F;
+  if (theta & 0x40) ++secoffset;
+  uint8_t section = offset >> 4;
+  uint8_t s2 = section * 2;
+  const uint8_t *p = b_m16_interleave + s2;
+  uint8_t b = *p++;
+  uint8_t m16 = *p;
+  uint8_t mx = (m16 * secoffset) >> 4;
+  int8_t y = mx + b;
+  if (theta & 0x80) y = -y;
+  return y + 128;
+}
+
+struct CRGB {
+  union {
+    struct { uint8_t r, g, b; };
+    uint8_t raw[3];
+  };
+
+  enum HTMLColorCode : uint32_t {
+    Black = 0x000000, White = 0xFFFFFF, Red = 0xFF0000,
+    Green = 0x008000, Blue = 0x0000FF
+  };
+
+  CRGB() : r(0), g(0), b(0) {}
+  constexpr CRGB(uint8_t ir, uint8_t ig, uint8_t ib) : r(ir), g(ig), b(ib) {}
+  constexpr CRGB(uint32_t c) : r((c >> 16) & 0xFF), g((c >> 8) & 0xFF), b(c & 0xFF) {}
+  constexpr CRGB(HTMLColorCode c) : CRGB((uint32_t)c) {}
+
+  uint8_t &operator[](int i) { return raw[i]; }
+  const uint8_t &operator[](int i) const { return raw[i]; }
+
+  CRGB &nscale8(uint8_t s) { r = scale8(r, s); g = scale8(g, s); b = scale8(b, s); return *this; }
+  CRGB &nscale8_video(uint8_t s) { r = scale8_video(r, s); g = scale8_video(g, s); b = scale8_video(b, s); return *this; }
+  CRGB &fadeToBlackBy(uint8_t f) { return nscale8(255 - f); }
+  CRGB &operator+=(const CRGB &o) { r = qadd8(r, o.r); g = qadd8(g, o.g); b = qadd8(b, o.b); return *this; }
+  CRGB &operator%=(uint8_t s) { return nscale8_video(s); }
+  explicit operator bool() const { return r || g || b; }
+  uint8_t getAverageLight() const { return (r + g + b) / 3; }
+};
+
+inline bool operator==(const CRGB &a, const CRGB &b) { return a.r == b.r && a.g == b.g && a.b == b.b; }
+inline bool operator!=(const CRGB &a, const CRGB &b) { return !(a == b); }
+inline CRGB operator+(const CRGB &a, const CRGB &b) { CRGB c = a; c += b; return c; }
+inline CRGB operator%(const CRGB &a, uint8_t s) { CRGB c = a; c.nscale8_video(s); return c; }
+
+inline CRGB blend(const CRGB &a, const CRGB &b, uint8_t f) {
+  return CRGB(lerp8by8(a.r, b.r, f), lerp8by8(a.g, b.g, f), lerp8by8(a.b, b.b, f));
+}
+inline void fill_solid(CRGB *l, int n, const CRGB &c) { for (int i = 0; i < n; i++) l[i] = c; }
+inline void fadeToBlackBy(CRGB *l, uint16_t n, uint8_t f) { for (int i = 0; i < n; i++) l[i].fadeToBlackBy(f); }
+
+typedef uint32_t TProgmemRGBPalette16[16];
+
+enum EOrder { RGB = 0012, RBG = 0021, GRB = 0102, GBR = 0120, BRG = 0201, BGR = 0210 };
+enum ESPIChipsets { LPD8806, WS2801, WS2803, SM16716, P9813, APA102, SK9822, DOTSTAR };
+template <uint8_t DATA_PIN> class WS2812 {};
+template <uint8_t DATA_PIN> class WS2811 {};
+template <uint8_t DATA_PIN> class SK6812 {};
+
+#define DATA_RATE_MHZ(X) ((X) * 1000000UL)
+#define DISABLE_DITHER 0x00
+#define BINARY_DITHER  0x01
+
+namespace host {
+
+constexpr int MAX_CTRL = 16;
+
+struct Controller {
+  CRGB *data = nullptr;
+  int n = 0;
+  int dataPin = -1;
+  int clockPin = -1;            // тактируемые ленты
+  uint32_t wireNsPerLed = 30000;
+  std::string wire;             // последний переданный кадр, по 3 байта RGB
+  int shows = 0;
+};
+
+extern Controller ctrls[MAX_CTRL];
+extern int ctrlCount;
+extern int shows;               // вызовов FastLED.show()
+extern int ctrlShows;           // вызовов showLeds() одного контроллера
+extern bool modelWire;          // show() занимает время передачи самой длинной ленты
+extern uint64_t showCostUs;     // и сверх него столько
+extern void (*onShow)();        // после каждого show()
+
+void transmit(int c, uint8_t brightness, uint8_t dither);
+void show(uint8_t brightness, uint8_t dither);
+
+}  // namespace host
+
+class CLEDController {
+public:
+  explicit CLEDController(int index) : index(index) {}
+  CLEDController &setDither(uint8_t d) { dither = d; return *this; }
+  CLEDController &setCorrection(uint32_t) { return *this; }
+  void showLeds(uint8_t brightness);
+  CRGB *leds() { return host::ctrls[index].data; }
+  int size() const { return host::ctrls[index].n; }
+
+  int index;
+  uint8_t dither = BINARY_DITHER;
+};
+
+class CFastLED {
+public:
+  template <template <uint8_t> class CHIPSET, uint8_t DATA_PIN, EOrder ORDER>
+  CLEDController &addLeds(CRGB *data, int n) {
+    return add(data, n, DATA_PIN, -1, 30000);
+  }
+
+  template <ESPIChipsets CHIPSET, uint8_t DATA_PIN, uint8_t CLOCK_PIN, EOrder ORDER, uint32_t SPI_HZ>
+  CLEDController &addLeds(CRGB *data, int n) {
+    return add(data, n, DATA_PIN, CLOCK_PIN, 32000000000ULL / SPI_HZ);
+  }
+
+  template <ESPIChipsets CHIPSET, uint8_t DATA_PIN, uint8_t CLOCK_PIN, EOrder ORDER>
+  CLEDController &addLeds(CRGB *data, int n) {
+    return addLeds<CHIPSET, DATA_PIN, CLOCK_PIN, ORDER, DATA_RATE_MHZ(12)>(data, n);
+  }
+
+  void setBrightness(uint8_t b) { brightness = b; }
+  uint8_t getBrightness() const { return brightness; }
+  void setDither(uint8_t d) { dither = d; }
+  uint8_t getDither() const { return dither; }
+  void setMaxRefreshRate(uint16_t, bool = false) {}
+  void show() { host::show(brightness, dither); }
+  void show(uint8_t b) { host::show(b, dither); }
+  void clear(bool write = false);
+  int count() const { return host::ctrlCount; }
+  CLEDController &operator[](int i) { return ctrl[i]; }
+
+  uint8_t brightness = 255;
+  uint8_t dither = BINARY_DITHER;
+
+private:
+  CLEDController &add(CRGB *data, int n, int dataPin, int clockPin, uint32_t nsPerLed);
+  CLEDController ctrl[host::MAX_CTRL] = {
+    CLEDController(0), CLEDController(1), CLEDController(2), CLEDController(3),
+    CLEDController(4), CLEDController(5), CLEDController(6), CLEDController(7),
+    CLEDController(8), CLEDController(9), CLEDController(10), CLEDController(11),
+    CLEDController(12), CLEDController(13), CLEDController(14), CLEDController(15)
+  };
+};
+
+extern CFastLED FastLED;
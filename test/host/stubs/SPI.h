@@ -0,0 +1,42 @@
+// Хост-шим SPI: transfer() отдаёт байты, которые положил тест
+// (например, состояние цепочки 74HC165); с host::modelBus — за время
+// своих битов
+#pragma once
+#include "Arduino.h"
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+#define SPI_MODE0 0x00
+
+class SPISettings {
+public:
+  SPISettings() {}
+  SPISettings(uint32_t hz, uint8_t order, uint8_t mode) : hz(hz), order(order), mode(mode) {}
+  uint32_t hz = 1000000;
+  uint8_t order = MSBFIRST;
+  uint8_t mode = SPI_MODE0;
+};
+
+class SPIClass {
+public:
+  void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1) {
+    sckPin = sck; misoPin = miso; mosiPin = mosi; ssPin = ss;
+  }
+  void end() {}
+  void beginTransaction(SPISettings s) { settings = s; }
+  void endTransaction() {}
+  uint8_t transfer(uint8_t) { uint8_t b = 0xFF; transfer(&b, 1); return b; }
+  void transfer(void *buf, size_t n) {
+    for (size_t i = 0; i < n; i++) ((uint8_t *)buf)[i] = i < sizeof(in) ? in[i] : 0xFF;
+    transfers++;
+    host::busBits(n * 8, settings.hz);
+  }
+
+  // хост
+  int sckPin = -1, misoPin = -1, mosiPin = -1, ssPin = -1;
+  SPISettings settings;
+  uint8_t in[32];               // что придёт на MISO
+  int transfers = 0;
+};
+
+extern SPIClass SPI;
@@ -0,0 +1,49 @@
+// Хост-шим I2C с моделью MCP23017: регистры по адресам 0x20..0x27,
+// GPIOA/GPIOB читаются из входов, которые выставляет тест. С
+// host::modelBus каждая посылка занимает время своих битов: байт с ACK —
+// 9 тактов, старт и стоп — ещё 2
+#pragma once
+#include "Arduino.h"
+
+namespace host {
+
+struct Mcp23017 {
+  bool present = false;
+  uint8_t reg[0x16];
+  uint8_t inputs[2] = { 0xFF, 0xFF };   // уровни на портах A и B
+  uint8_t pointer = 0;
+  Mcp23017() { memset(reg, 0, sizeof(reg)); }
+};
+
+extern Mcp23017 mcp[8];
+
+}  // namespace host
+
+class TwoWire {
+public:
+  bool begin() { return begin(21, 22, 100000); }
+  bool begin(int sda, int scl, uint32_t hz = 100000) {
+    sdaPin = sda; sclPin = scl; clock = hz; started = true;
+    return true;
+  }
+  void setClock(uint32_t hz) { clock = hz; }
+
+  void beginTransmission(uint8_t addr) { target = addr; txLen = 0; }
+  size_t write(uint8_t v) { if (txLen < sizeof(tx)) tx[txLen++] = v; return 1; }
+  uint8_t endTransmission(bool stop = true);
+  uint8_t requestFrom(int addr, int n, bool stop = true);
+  int available() { return rxLen - rxPos; }
+  int read() { return rxPos < rxLen ? rx[rxPos++] : -1; }
+
+  // хост
+  int sdaPin = -1, sclPin = -1;
+  uint32_t clock = 0;
+  bool started = false;
+  uint8_t target = 0;
+  uint8_t tx[16];
+  size_t txLen = 0;
+  uint8_t rx[16];
+  int rxLen = 0, rxPos = 0;
+};
+
+extern TwoWire Wire;
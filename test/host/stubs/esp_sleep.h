@@ -0,0 +1,20 @@
+// Хост-шим light sleep: сон двигает виртуальное время до таймера или,
+// с пробуждением по GPIO, до смены уровня на будящем пине (setPinAt)
+#pragma once
+#include "Arduino.h"
+
+namespace host {
+extern uint64_t wakeAfterUs;
+extern bool gpioWake;
+uint64_t sleepUs(uint64_t timerUs);   // сколько продлится сон
+}
+
+inline int esp_sleep_enable_timer_wakeup(uint64_t us) { host::wakeAfterUs = us; return 0; }
+inline int esp_sleep_enable_gpio_wakeup() { host::gpioWake = true; return 0; }
+inline int esp_light_sleep_start() {
+  const uint64_t us = host::sleepUs(host::wakeAfterUs);
+  host::sleeps++;
+  host::sleptUs += us;
+  host::advance(us);
+  return 0;
+}
@@ -0,0 +1,48 @@
+// Хост-шим сторожевого таймера: счётчики и TWDT, запущенный ядром
+// (host::wdtRunning) или нет, как у IDF 5
+#pragma once
+#include "Arduino.h"
+
+#define ESP_ARDUINO_VERSION_MAJOR 3
+
+typedef int esp_err_t;
+#define ESP_OK                0
+#define ESP_FAIL              -1
+#define ESP_ERR_INVALID_STATE 0x103
+
+typedef struct {
+  uint32_t timeout_ms;
+  uint32_t idle_core_mask;
+  bool trigger_panic;
+} esp_task_wdt_config_t;
+
+namespace host {
+extern int wdtFeeds;
+extern bool wdtRunning;          // TWDT запущен
+extern uint32_t wdtTimeoutMs;
+extern esp_err_t wdtAddErr;      // ответ esp_task_wdt_add()
+}
+
+// IDF 4: init поверх запущенного меняет таймаут
+inline esp_err_t esp_task_wdt_init(uint32_t timeoutS, bool) {
+  host::wdtRunning = true;
+  host::wdtTimeoutMs = timeoutS * 1000;
+  return ESP_OK;
+}
+
+// IDF 5: init только один раз, reconfigure только после него
+inline esp_err_t esp_task_wdt_init(const esp_task_wdt_config_t *cfg) {
+  if (host::wdtRunning) return ESP_ERR_INVALID_STATE;
+  host::wdtRunning = true;
+  host::wdtTimeoutMs = cfg->timeout_ms;
+  return ESP_OK;
+}
+
+inline esp_err_t esp_task_wdt_reconfigure(const esp_task_wdt_config_t *cfg) {
+  if (!host::wdtRunning) return ESP_ERR_INVALID_STATE;
+  host::wdtTimeoutMs = cfg->timeout_ms;
+  return ESP_OK;
+}
+
+inline esp_err_t esp_task_wdt_add(void *) { return host::wdtAddErr; }
+inline esp_err_t esp_task_wdt_reset() { host::wdtFeeds++; return ESP_OK; }
@@ -0,0 +1,40 @@
+// Полосы счёта с пульсацией нового сегмента (вариант BAR_PULSE_FRAMES 8).
+// Очко, набранное до конца пульсации прошлого сегмента, не должно
+// оставить тот сегмент притушенным: после всех пульсаций лента совпадает
+// с lanePixel по всей длине обеих полос
+#include SKETCH
+#include "host.h"
+
+using namespace host;
+
+static int barMismatches(int s) {
+  const LaneRender &r = laneRender[s];
+  int bad = 0;
+  for (int i = 0; i < NUM_LEDS; i++) {
+    if (i >= r.barL && i < NUM_LEDS - r.barR) continue;
+    if (pixel(s, i) != lanePixel(s, i)) bad++;
+  }
+  return bad;
+}
+
+int main() {
+  bootBoard();
+  press(0, 'L');
+  runUntil(millis() + 2000);
+  CHECK_EQ(globalState, G_PLAYING);
+
+  // Два очка каждой стороне с разрывом в два кадра
+  game[0].scoreL += rules.scoreStep;
+  game[0].scoreR += rules.scoreStep;
+  run(2 * GAME_DELAY);
+  CHECK(laneRender[0].pulseL > 0);
+  game[0].scoreL += rules.scoreStep;
+  game[0].scoreR += rules.scoreStep;
+  run((BAR_PULSE_FRAMES + 2) * GAME_DELAY);
+
+  CHECK_EQ(laneRender[0].pulseL, 0);
+  CHECK_EQ(laneRender[0].pulseR, 0);
+  CHECK_EQ(laneRender[0].barL, 2 * rules.scoreStep);
+  CHECK_EQ(barMismatches(0), 0);
+  return report("bars");
+}
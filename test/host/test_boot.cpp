@@ -0,0 +1,65 @@
+// Строка BOOT: платы с моделью передачи лент и шины расширителей.
+// Первый (чёрный) кадр уходит раньше всей остальной настройки — не
+// позже передачи самой длинной ленты и FIRST_FRAME_SLACK_US; кнопки
+// опрашиваются не позже INPUT_LIMIT_US после него, а кнопка, зажатая
+// до первого прохода loop(), им же и принята. Вариант
+// boot_mcp23017 — с настройкой MCP23017 по I2C на критическом пути
+#include SKETCH
+#include "host.h"
+
+using namespace host;
+
+namespace {
+
+constexpr unsigned long FIRST_FRAME_SLACK_US = 1000;
+constexpr unsigned long INPUT_LIMIT_US = 5000;
+
+// "BOOT: first frame F us, input I us, ready R us"
+struct BootLine {
+  unsigned long firstFrameUs, inputUs, readyUs;
+};
+
+bool parseBoot(BootLine &b) {
+  std::vector<std::string> found = lines("BOOT: ");
+  CHECK_EQ(found.size(), 1u);
+  if (found.size() != 1) return false;
+  int n = sscanf(found[0].c_str(), "BOOT: first frame %lu us, input %lu us, ready %lu us", &b.firstFrameUs,
+                 &b.inputUs, &b.readyUs);
+  CHECK_EQ(n, 3);
+  return n == 3;
+}
+
+// Левая кнопка дорожки 0 на источнике варианта, низкий уровень — нажата
+void holdFirst(bool down) {
+  uint8_t level = down ? 0xFE : 0xFF;
+  if (std::is_same<INPUT_SOURCE, InMcp23017>::value) mcp[0].inputs[0] = level;
+  else if (std::is_same<INPUT_SOURCE, InShift165>::value) SPI.in[0] = level;
+  else setPin(BTN_L[0], down ? LOW : HIGH);
+}
+
+}  // namespace
+
+int main() {
+  modelWire = true;
+  modelBus = true;
+  memset(SPI.in, 0xFF, sizeof(SPI.in));
+  for (int c = 0; c < 8; c++) mcp[c].present = c < InMcp23017::CHIPS;
+  setup();
+  CHECK_EQ(shows + ctrlShows, 1);    // до loop() — только чёрный кадр
+  holdFirst(true);                   // INPUT_PULLUP шима поднимает пин в setup()
+  tick();
+  CHECK(inputPending() || globalState == G_START_FILL);
+  while (!::boot.done) tick();
+  holdFirst(false);
+
+  BootLine b{};
+  if (!parseBoot(b)) return report("boot");
+  printf("boot: first frame %lu us (wire %lu us), input %lu us, ready %lu us\n", b.firstFrameUs,
+         (unsigned long)WIRE_US, b.inputUs, b.readyUs);
+  CHECK_EQ(b.firstFrameUs, ::boot.firstFrameUs);
+  CHECK(b.firstFrameUs <= WIRE_US + FIRST_FRAME_SLACK_US);
+  CHECK(b.inputUs >= b.firstFrameUs);
+  CHECK(b.inputUs - b.firstFrameUs <= INPUT_LIMIT_US);
+  CHECK(b.readyUs >= b.inputUs);
+  return report("boot");
+}
@@ -0,0 +1,70 @@
+// Поток CAPTURE туда и обратно: после каждого показа декодер из
+// capture_decode.h должен держать ровно то, что скетч считает
+// отправленным (captured[][]). Пока буфер передачи мал, кадры уходят
+// частями и отстают от лент; после его освобождения декодер догоняет
+// ленты полностью. Поток пишется в capture.bin для capture_convert
+#include SKETCH
+#include "host.h"
+#include "capture_decode.h"
+
+using namespace host;
+
+capture::Decoder dec;
+size_t fed = 0;
+int frameFaults = 0;
+int lagging = 0;     // кадров, где отправленное ещё не совпало с лентой
+
+bool sameAs(bool leds) {
+  if (dec.lanes != NUM_STRIPS || dec.leds != NUM_LEDS) return false;
+  for (int s = 0; s < NUM_STRIPS; s++) {
+    for (int i = 0; i < NUM_LEDS; i++) {
+      const CRGB &want = leds ? pixel(s, i) : captured[s][i];
+      const capture::Pixel &got = dec.frame[s][i];
+      if (got.r != want.r || got.g != want.g || got.b != want.b) return false;
+    }
+  }
+  return true;
+}
+
+void onCaptureShow() {
+  const std::string &out = Serial.out;
+  dec.feed((const uint8_t *)out.data() + fed, out.size() - fed, [](const capture::Decoder &) {});
+  fed = out.size();
+  if (!dec.lanes) return;
+  if (!sameAs(false)) frameFaults++;
+  if (!sameAs(true)) lagging++;
+}
+
+int main() {
+  onShow = onCaptureShow;
+  bootBoard();
+  run(1000);
+  press(0, 'L');
+  run(4000);
+  CHECK_EQ(globalState, G_PLAYING);
+  CHECK_EQ(lagging, 0);
+
+  // Узкий буфер: в кадр влезает несколько участков
+  Serial.setTxBufferSize(60);
+  run(1000);
+  CHECK(lagging > 0);
+  Serial.setTxBufferSize(2048);
+  run(200);
+  CHECK(sameAs(true));
+
+  for (int k = 0; k < 60000 && globalState != G_DEMO; k++) tick();
+  run(500);
+  CHECK(sameAs(true));
+
+  printf("frames %u, keys %u, lagging %d, %zu bytes\n", dec.frames, dec.keys, lagging, Serial.out.size());
+  CHECK_EQ(frameFaults, 0);
+  CHECK_EQ(dec.errors, 0);
+  CHECK(dec.keys >= 2);
+
+  FILE *f = fopen("capture.bin", "wb");
+  if (f) {
+    fwrite(Serial.out.data(), 1, Serial.out.size(), f);
+    fclose(f);
+  }
+  return report("capture");
+}
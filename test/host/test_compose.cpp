@@ -0,0 +1,93 @@
+// Инкрементальная компоновка против полного пересчёта lanePixel():
+// вариант с FRAME_VERIFY и медленным путём (BAR_GRADIENT, комета) через
+// демо, заполнение, игру и GAME_OVER не должен печатать ни одного FV:.
+// Сброшенная дорожка — один фон, без шарика.
+// Разводка: compose --dump <файл> пишет px(s, i) всех дорожек после
+// каждого show(); layout_map (LAYOUT_IDENTITY 0, серпантин и разрезанная
+// дорожка) с --against <файл> проходит тот же прогон и требует тех же
+// пикселей дорожек кадр в кадр. Пиксели берутся из leds[] по кускам
+// LANE_LAYOUT, мимо LAYOUT_MAP и px(), и сверяются с px(): так проверена
+// и сама таблица
+#include SKETCH
+#include "host.h"
+
+#include <fstream>
+#include <iterator>
+
+using namespace host;
+
+namespace {
+
+constexpr size_t FRAME_BYTES = NUM_STRIPS * NUM_LEDS * 3;
+
+std::string laneFrames;
+
+// Позиция i дорожки s в leds[] по кускам разводки
+const CRGB &wired(int s, int i) {
+  for (int k = 0; k < LANE_SEGMENTS; k++) {
+    const LaneSegment &seg = LANE_LAYOUT[s][k];
+    if (i < seg.length) return leds[seg.ctrl][seg.reversed ? seg.offset + seg.length - 1 - i : seg.offset + i];
+    i -= seg.length;
+  }
+  abort();
+}
+
+int mapFaults = 0;
+
+void recordLanes() {
+  for (int s = 0; s < NUM_STRIPS; s++)
+    for (int i = 0; i < NUM_LEDS; i++) {
+      const CRGB &c = wired(s, i);
+      mapFaults += c != px(s, i);
+      laneFrames.append({ (char)c.r, (char)c.g, (char)c.b });
+    }
+}
+
+// Первое расхождение с прогоном тождественной разводки
+void compareLanes(const char *path) {
+  std::ifstream in(path, std::ios::binary);
+  const std::string want((std::istreambuf_iterator<char>(in)), {});
+  CHECK(!want.empty());
+  CHECK_EQ(laneFrames.size() / FRAME_BYTES, want.size() / FRAME_BYTES);
+  for (size_t k = 0; k < min(want.size(), laneFrames.size()); k++) {
+    if (want[k] == laneFrames[k]) continue;
+    const size_t px = k % FRAME_BYTES / 3;
+    printf("кадр %zu: дорожка %zu, позиция %zu отличается от %s\n", k / FRAME_BYTES + 1, px / NUM_LEDS,
+           px % NUM_LEDS, path);
+    CHECK_EQ(laneFrames[k], want[k]);
+    return;
+  }
+  printf("%zu кадров дорожек совпали с %s (%d контроллеров)\n", laneFrames.size() / FRAME_BYTES, path,
+         NUM_CONTROLLERS);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const char *dump = argc > 2 && strcmp(argv[1], "--dump") == 0 ? argv[2] : nullptr;
+  const char *against = argc > 2 && strcmp(argv[1], "--against") == 0 ? argv[2] : nullptr;
+  onShow = recordLanes;
+  bootBoard();
+  run(1500);   // демо
+  press(0, 'L');
+  runUntil(millis() + 2000);
+  CHECK_EQ(globalState, G_PLAYING);
+
+  // Без нажатий дорожки проигрывают очко за очком до конца матча
+  for (int k = 0; k < 120000 && globalState == G_PLAYING; k++) tick();
+  CHECK(globalState != G_PLAYING);
+  run(3000);
+
+  for (const std::string &l : lines("FV:")) printf("%s\n", l.c_str());
+  CHECK_EQ(verifyFaults, 0);
+
+  onShow = nullptr;
+  CHECK_EQ(mapFaults, 0);
+  if (dump) std::ofstream(dump, std::ios::binary).write(laneFrames.data(), laneFrames.size());
+  if (against) compareLanes(against);
+
+  resetLaneRender(0);
+  for (int i = 0; i < NUM_LEDS; i++)
+    if (lanePixel(0, i) != laneColors[0][PAL_BG]) { CHECK_EQ(i, -1); break; }
+  return report(LAYOUT_IDENTITY ? "compose" : "layout_map");
+}
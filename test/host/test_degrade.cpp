@@ -0,0 +1,144 @@
+// Ступени деградации под медленным show(): шим добавляет к каждому
+// показу host::showCostUs. Ленты RMT (OutClockless) передаются
+// одновременно, их супервизор доводит только до DEG_HALF_FPS (DEG_MAX);
+// тактируемые (OutClocked) — до DEG_SKIP_STATIC, где законченная дорожка
+// передаётся один раз, а остальные — каждый кадр, с текущей яркостью
+// FastLED. Матч не кончается (maxScore велик), поэтому подъём и спуск
+// идут в установившемся G_PLAYING, и на каждой ступени проверяются
+// дизеринг и промежуток между переданными кадрами.
+// Заодно watchdog супервизора: таймаут доходит до TWDT, запущен он ядром
+// или нет, а ошибка настройки попадает в строку WDT:
+#include SKETCH
+#include "host.h"
+
+#include <algorithm>
+#include <map>
+
+using namespace host;
+
+namespace {
+
+// Переданные кадры по ступеням: промежутки между ними и дизеринг
+struct LevelStats {
+  std::vector<unsigned long> gapsMs;
+  bool ditherOn = false, ditherOff = false;
+};
+
+std::map<int, LevelStats> stats;
+unsigned long lastSentMs = 0;
+int lastSentLevel = -1;
+int sentBefore = 0;
+
+// Кадр передан, если за миллисекунду был show() или showCtrl()
+void tickAndRecord() {
+  tick();
+  CHECK_EQ(globalState, G_PLAYING);
+  if (shows + ctrlShows == sentBefore) return;
+  sentBefore = shows + ctrlShows;
+  LevelStats &st = stats[sup.level];
+  if (lastSentLevel == sup.level) st.gapsMs.push_back(millis() - lastSentMs);
+  (FastLED.getDither() ? st.ditherOn : st.ditherOff) = true;
+  lastSentMs = millis();
+  lastSentLevel = sup.level;
+}
+
+unsigned long medianGap(std::vector<unsigned long> gaps) {
+  if (gaps.empty()) return 0;
+  std::sort(gaps.begin(), gaps.end());
+  return gaps[gaps.size() / 2];
+}
+
+void checkWatchdog() {
+  CHECK_EQ(wdtTimeoutMs, WDT_TIMEOUT_S * 1000);
+  CHECK_EQ(watchdogErr, ESP_OK);
+  CHECK(lines("WDT:").empty());
+
+  wdtRunning = false;   // ядро без TWDT: reconfigure отказывает, init запускает
+  wdtTimeoutMs = 0;
+  watchdogBegin();
+  CHECK(wdtRunning);
+  CHECK_EQ(wdtTimeoutMs, WDT_TIMEOUT_S * 1000);
+  CHECK_EQ(watchdogErr, ESP_OK);
+
+  wdtAddErr = ESP_FAIL;
+  watchdogBegin();
+  CHECK_EQ(watchdogErr, ESP_FAIL);
+  reportWatchdog();
+  CHECK_EQ(lines("WDT: init error -1").size(), 1u);
+  wdtAddErr = ESP_OK;
+  watchdogBegin();
+}
+
+}  // namespace
+
+int main() {
+  bootBoard();
+  checkWatchdog();
+  press(0, 'L');
+  runUntil(millis() + 2000);
+  CHECK_EQ(globalState, G_PLAYING);
+  rules.maxScore = 30000;
+  sentBefore = shows + ctrlShows;
+
+  // Подъём: ступени только растут, по одной
+  showCostUs = 40000;   // больше GAME_DELAY
+  int prev = sup.level;
+  for (int k = 0; k < 3000 && sup.level < DEG_MAX; k++) {
+    tickAndRecord();
+    CHECK(sup.level == prev || sup.level == prev + 1);
+    prev = sup.level;
+  }
+  CHECK_EQ(sup.level, DEG_MAX);
+  CHECK_EQ(sup.level, LED_OUTPUT::PARALLEL_SHOW ? DEG_HALF_FPS : DEG_SKIP_STATIC);
+
+  // Потолок: перегрузка дальше DEG_MAX не ведёт
+  for (int k = 0; k < 3000; k++) tickAndRecord();
+  CHECK_EQ(sup.level, DEG_MAX);
+  CHECK_EQ(lines("SUP: level").size(), (size_t)DEG_MAX);
+
+  if (!LED_OUTPUT::PARALLEL_SHOW) {
+    // Дорожка 0 закончена: её лента уходит ещё один раз с заливкой
+    game[0].scoreL = rules.maxScore;
+    FastLED.setBrightness(BRIGHTNESS / 2);
+    run(200);
+    int doneShows = ctrls[0].shows;
+    int liveShows = ctrls[1].shows;
+    run(600);
+    CHECK_EQ(ctrls[0].shows, doneShows);
+    CHECK(ctrls[1].shows > liveShows);
+    CHECK_EQ((uint8_t)ctrls[0].wire[1], scale8(laneColor(0, PAL_LEFT).g, BRIGHTNESS / 2));
+    sentBefore = shows + ctrlShows;
+    lastSentLevel = -1;
+  }
+
+  // Спуск: быстрые кадры возвращают ступени по одной до DEG_NONE
+  showCostUs = 0;
+  prev = sup.level;
+  int steps = 0;
+  const int recoverMs = RECOVER_LIMIT * GAME_DELAY * 2 + 500;
+  for (int k = 0; k < recoverMs * DEG_MAX && sup.level > DEG_NONE; k++) {
+    tickAndRecord();
+    CHECK(sup.level == prev || sup.level == prev - 1);
+    steps += sup.level != prev;
+    prev = sup.level;
+  }
+  CHECK_EQ(sup.level, DEG_NONE);
+  CHECK_EQ(steps, DEG_MAX);
+  CHECK_EQ(lines("SUP: level").size(), (size_t)DEG_MAX * 2);
+  for (int k = 0; k < 500; k++) tickAndRecord();
+
+  // На каждой ступени: дизеринг только без деградации, с DEG_HALF_FPS
+  // кадр передаётся через раз
+  for (int level = DEG_NONE; level <= DEG_MAX; level++) {
+    const LevelStats &st = stats[level];
+    const unsigned long want = GAME_DELAY * (level >= DEG_HALF_FPS ? 2 : 1);
+    const unsigned long got = medianGap(st.gapsMs);
+    printf("ступень %d: кадров %zu, промежуток %lu мс (ждём %lu), дизеринг %s\n", level, st.gapsMs.size(), got,
+           want, st.ditherOn ? (st.ditherOff ? "вкл/выкл" : "вкл") : "выкл");
+    CHECK(st.gapsMs.size() >= 10);
+    CHECK(got >= want && got <= want + 1);
+    CHECK_EQ(st.ditherOn, level == DEG_NONE);
+    CHECK_EQ(st.ditherOff, level != DEG_NONE);
+  }
+  return report("degrade");
+}
@@ -0,0 +1,183 @@
+// Подстройка сложности (DIFFICULTY 1) на хосте.
+// Скорость: каждый уровень даёт свою скорость мяча, без ступеньки на
+// GAME_DELAY — время пролёта от центра до края следует за speedDelay.
+// Сходимость: на дорожках боты разной точности (разброс момента нажатия
+// от 8 до 120 мс) играют матч за матчем полчаса. Уровни расходятся по
+// умению, а во второй половине прогона почти не разворачиваются —
+// контроллер не качается
+#include SKETCH
+#include "host.h"
+
+#include <random>
+
+using namespace host;
+
+namespace {
+
+void startMatchByPress() {
+  while (globalState != G_DEMO) tick();
+  press(0, 'L');
+  for (int k = 0; k < 5000 && globalState != G_PLAYING; k++) tick();
+}
+
+// Время пролёта мяча от центра до края по интервалам между очками
+void checkSpeeds() {
+  for (int level = DIFF_MIN_LEVEL; level <= DIFF_MAX_LEVEL; level++) {
+    startMatchByPress();
+    CHECK_EQ(globalState, G_PLAYING);
+    StripGame &g = game[0];
+    skill[0].hold = 255;   // без смены уровня посреди замера
+    applyDifficulty<GAME_MODE>(g, level);
+    g.lastMove = gameNow();
+
+    int points = 0, last = g.scoreL + g.scoreR;
+    unsigned long pointAt = 0, sum = 0;
+    int intervals = 0;
+    while (globalState == G_PLAYING && points < 4) {
+      tick();
+      if (g.scoreL + g.scoreR == last) continue;
+      last = g.scoreL + g.scoreR;
+      if (points++ > 0) {
+        sum += millis() - pointAt;
+        intervals++;
+      }
+      pointAt = millis();
+    }
+    CHECK(intervals >= 2);
+    // От центра до края NUM_LEDS / 2 шагов в одну сторону, на шаг больше в другую
+    long want = (long)(NUM_LEDS + 1) * g.speedDelay / 2;
+    long got = intervals ? (long)(sum / intervals) : 0;
+    printf("level %+d: speedDelay %lu ms, center to edge %ld ms (want %ld)\n", level, g.speedDelay, got, want);
+    CHECK(labs(got - want) <= (long)g.speedDelay + GAME_DELAY);
+  }
+}
+
+struct Bot {
+  double sigmaMs;
+  int lastDir;
+  bool pending[2];            // нажатие на этот подлёт назначено
+  unsigned long pressAt[2];   // 0 — уже нажал
+  unsigned long releaseAt[2]; // 0 — кнопка отпущена
+};
+
+// Игрок видит мяч с опозданием: в среднем полкадра и передача ленты
+constexpr double SEEN_LAG_MS = GAME_DELAY / 2.0 + WIRE_US / 1000.0;
+
+// Бот целится в середину зоны по времени, когда мяч там будет виден;
+// ошибка — нормальная.
+// Отбивание разворачивает мяч, пока кнопка ещё держится, поэтому
+// отпускание отслеживается отдельно от подлёта
+void botTick(int s, Bot &b, std::mt19937 &rng) {
+  const StripGame &g = game[s];
+  const unsigned long now = millis();
+  for (int side = 0; side < 2; side++) {
+    char key = side == 0 ? 'L' : 'R';
+    if (b.releaseAt[side] && now >= b.releaseAt[side]) {
+      release(s, key);
+      b.releaseAt[side] = 0;
+    }
+  }
+
+  if (g.direction != b.lastDir) {
+    b.pending[0] = b.pending[1] = false;
+    b.lastDir = g.direction;
+  }
+  for (int side = 0; side < 2; side++) {
+    bool toward = side == 0 ? g.direction == DIR_LEFT : g.direction == DIR_RIGHT;
+    if (toward && !b.pending[side]) {
+      double target = (side == 0 ? g.zoneL : g.zoneR) + g.hitZone / 2.0;
+      double cells = side == 0 ? g.ballPos - target : target - g.ballPos;
+      std::normal_distribution<double> err(0, b.sigmaMs);
+      double at = g.lastMove + (cells + 0.5) * g.speedDelay + SEEN_LAG_MS + err(rng);
+      b.pressAt[side] = at < now ? now : (unsigned long)at;
+      b.pending[side] = true;
+    }
+    if (b.pending[side] && b.pressAt[side] && now >= b.pressAt[side] && !b.releaseAt[side]) {
+      hold(s, side == 0 ? 'L' : 'R');
+      b.releaseAt[side] = now + 20;
+      b.pressAt[side] = 0;   // до смены направления больше не нажимает
+    }
+  }
+}
+
+void checkConvergence() {
+  const double SIGMA[NUM_STRIPS] = { 8, 25, 60, 25, 120 };
+  constexpr unsigned long RUN_MS = 30UL * 60 * 1000;
+  Bot bots[NUM_STRIPS];
+  std::mt19937 rng(49);
+  // Матч замера скорости доигрывают те же боты, уровни считаются с нуля
+  for (int s = 0; s < NUM_STRIPS; s++) bots[s] = Bot{ SIGMA[s], 0, {}, {}, {} };
+  difficultyReset();
+  for (int s = 0; s < NUM_STRIPS; s++) applyDifficulty<GAME_MODE>(game[s], 0);
+
+  // Во второй половине: сумма уровня по миллисекундам, размах, смены
+  // и развороты — смены, обратные предыдущей
+  int level[NUM_STRIPS] = {}, lo[NUM_STRIPS], hi[NUM_STRIPS], changes[NUM_STRIPS] = {};
+  int lastStep[NUM_STRIPS] = {}, reversals[NUM_STRIPS] = {};
+  long long levelMs[NUM_STRIPS] = {};
+  long long lateMs = 0;
+  const unsigned long start = millis();
+  while (millis() - start < RUN_MS) {
+    if (globalState == G_DEMO) {
+      for (int s = 0; s < NUM_STRIPS; s++) {
+        release(s, 'L');
+        release(s, 'R');
+        bots[s] = Bot{ SIGMA[s], 0, {}, {}, {} };
+      }
+      startMatchByPress();
+      continue;
+    }
+    if (globalState == G_PLAYING)
+      for (int s = 0; s < NUM_STRIPS; s++)
+        if (game[s].state == PLAYING) botTick(s, bots[s], rng);
+    tick();
+
+    bool late = millis() - start > RUN_MS / 2;
+    if (late) lateMs++;
+    for (int s = 0; s < NUM_STRIPS; s++) {
+      if (!late) {
+        if (skill[s].level != level[s]) lastStep[s] = skill[s].level - level[s];
+        level[s] = lo[s] = hi[s] = skill[s].level;
+        continue;
+      }
+      levelMs[s] += skill[s].level;
+      if (skill[s].level == level[s]) continue;
+      int step = skill[s].level - level[s];
+      if (step == -lastStep[s]) reversals[s]++;
+      lastStep[s] = step;
+      level[s] = skill[s].level;
+      lo[s] = min(lo[s], level[s]);
+      hi[s] = max(hi[s], level[s]);
+      changes[s]++;
+    }
+  }
+
+  double mean[NUM_STRIPS];
+  for (int s = 0; s < NUM_STRIPS; s++) {
+    mean[s] = (double)levelMs[s] / lateMs;
+    printf("lane %d: sigma %3.0f ms, second half: level %+.2f (%+d..%+d), changes %d, reversals %d\n", s,
+           SIGMA[s], mean[s], lo[s], hi[s], changes[s], reversals[s]);
+  }
+
+  // Уровень следует за умением: точнее игрок — выше уровень
+  CHECK(mean[0] >= mean[1] && mean[0] >= mean[3]);
+  CHECK(mean[1] > mean[2] && mean[3] > mean[2]);
+  CHECK(mean[2] > mean[4]);
+  // Без качелей: развороты единичные. Игроку посередине (60 мс) подходят
+  // уровни от -3 до 0 — доля промахов на них почти одна, и уровень медленно
+  // бродит по этой полосе; остальные держатся у одного значения
+  const int SPAN[NUM_STRIPS] = { 1, 1, 3, 1, 1 };
+  for (int s = 0; s < NUM_STRIPS; s++) {
+    CHECK(hi[s] - lo[s] <= SPAN[s]);
+    CHECK(reversals[s] <= 2);
+  }
+}
+
+}  // namespace
+
+int main() {
+  bootBoard();
+  checkSpeeds();
+  checkConvergence();
+  return report("difficulty");
+}
@@ -0,0 +1,151 @@
+// Кадры встроенного сценария SCRIPT (SCENARIO 1) против золотого корпуса.
+// Корпус — отпечатки FH: каждого скомпонованного кадра (golden/frame_hash.txt)
+// и поток CAPTURE того же прогона (golden/frame_hash.cap), из которого
+// capture_decode.h восстанавливает сами кадры.
+//
+// Каждый кадр прогона декодируется из его же потока CAPTURE и сверяется
+// с золотым по каналам с допуском TOLERANCE: быстрые и дизеринговые пути
+// компоновки, которые округляют иначе, проходят, а сдвинутый шарик или
+// чужой цвет — нет. Отпечатки говорят, сколько кадров совпало точно;
+// с --exact тест требует совпадения всех отпечатков и "SCN: ok" (хеш
+// прогона SCENARIO_HASH задаёт вариант в CMakeLists.txt).
+// Обновление после намеренной смены картинки: frame_hash --update
+#include SKETCH
+#include "host.h"
+#include "capture_decode.h"
+
+#include <fstream>
+#include <iterator>
+
+using namespace host;
+
+namespace {
+
+constexpr int TOLERANCE = 4;   // уровней на канал
+
+const std::string GOLDEN = std::string(GOLDEN_DIR) + "/frame_hash";
+
+using Frame = std::vector<std::vector<capture::Pixel>>;
+
+struct Run {
+  std::vector<std::string> hashes;   // "<номер> <отпечаток>"
+  std::vector<Frame> frames;
+};
+
+// Поток Serial разбирается с места, где остановились: кадры CAPTURE
+// декодером, строки FH: и SCN: между пакетами — поиском по новым байтам
+struct Reader {
+  capture::Decoder dec;
+  size_t fed = 0;
+  size_t textAt = 0;
+  bool scnOk = false, scnFail = false;
+  Run run;
+
+  void poll() {
+    const std::string &out = Serial.out;
+    dec.feed((const uint8_t *)out.data() + fed, out.size() - fed,
+             [this](const capture::Decoder &d) { run.frames.push_back(d.frame); });
+    fed = out.size();
+    for (size_t at; (at = out.find("\r\n", textAt)) != std::string::npos; textAt = at + 2)
+      text(out, textAt, at);
+  }
+
+  // Строка от from до конца at; перед текстом может стоять хвост пакета
+  void text(const std::string &out, size_t from, size_t at) {
+    const std::string fhWant = "FH: " + std::to_string(run.hashes.size() + 1) + ' ';
+    size_t fh = out.rfind(fhWant, at);
+    if (fh != std::string::npos && fh >= from && at - fh == fhWant.size() + 16) {
+      run.hashes.push_back(out.substr(fh + 4, at - fh - 4));
+      return;
+    }
+    if (out.compare(from, 7, "SCN: ok") == 0) scnOk = true;
+    if (out.compare(from, 9, "SCN: fail") == 0) scnFail = true;
+    if (out.compare(from, 5, "SCN: ") == 0) printf("%s\n", out.substr(from, at - from).c_str());
+  }
+};
+
+Run loadGolden(std::string &stream) {
+  Run g;
+  std::ifstream in(GOLDEN + ".txt");
+  for (std::string line; std::getline(in, line);)
+    if (!line.empty() && line[0] != '#') g.hashes.push_back(line);
+
+  std::ifstream cap(GOLDEN + ".cap", std::ios::binary);
+  stream.assign(std::istreambuf_iterator<char>(cap), {});
+  capture::Decoder dec;
+  dec.feed((const uint8_t *)stream.data(), stream.size(),
+           [&g](const capture::Decoder &d) { g.frames.push_back(d.frame); });
+  return g;
+}
+
+// Наибольшая разница канала между кадрами, -1 — разный размер
+int distance(const Frame &a, const Frame &b) {
+  if (a.size() != b.size()) return -1;
+  int d = 0;
+  for (size_t s = 0; s < a.size(); s++) {
+    if (a[s].size() != b[s].size()) return -1;
+    for (size_t i = 0; i < a[s].size(); i++) {
+      d = max(d, abs(a[s][i].r - b[s][i].r));
+      d = max(d, abs(a[s][i].g - b[s][i].g));
+      d = max(d, abs(a[s][i].b - b[s][i].b));
+    }
+  }
+  return d;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const bool update = argc > 1 && strcmp(argv[1], "--update") == 0;
+  const bool exact = argc > 1 && strcmp(argv[1], "--exact") == 0;
+  Reader r;
+  bootBoard();
+  for (int k = 0; k < 60000 && !r.scnOk && !r.scnFail; k++) {
+    tick();
+    r.poll();
+  }
+  CHECK(r.scnOk || r.scnFail);
+  CHECK(!r.run.hashes.empty());
+  CHECK_EQ(r.run.hashes.size(), fh.frames);
+  CHECK_EQ(r.run.frames.size(), r.run.hashes.size());
+  CHECK_EQ(r.dec.errors, 0);
+
+  if (update) {
+    std::ofstream out(GOLDEN + ".txt");
+    out << "# FH: кадров встроенного сценария SCRIPT, номер и отпечаток; обновление: frame_hash --update\n";
+    for (const std::string &h : r.run.hashes) out << h << '\n';
+    std::ofstream(GOLDEN + ".cap", std::ios::binary).write(Serial.out.data(), Serial.out.size());
+    printf("golden: %zu кадров записано в %s.txt и .cap\n", r.run.hashes.size(), GOLDEN.c_str());
+    return report("frame_hash");
+  }
+
+  std::string stream;
+  Run want = loadGolden(stream);
+  CHECK_EQ(r.run.frames.size(), want.frames.size());
+  CHECK_EQ(want.hashes.size(), want.frames.size());
+
+  size_t same = 0, close = 0;
+  int worst = 0;
+  for (size_t k = 0; k < r.run.frames.size() && k < want.frames.size(); k++) {
+    if (k < want.hashes.size() && r.run.hashes[k] == want.hashes[k]) {
+      same++;
+      continue;
+    }
+    int d = distance(r.run.frames[k], want.frames[k]);
+    if (d >= 0 && d <= TOLERANCE) {
+      close++;
+      worst = max(worst, d);
+      continue;
+    }
+    printf("кадр %zu: отличие %d уровней, допуск %d\n", k + 1, d, TOLERANCE);
+    CHECK(d >= 0 && d <= TOLERANCE);
+    break;
+  }
+  printf("кадров %zu: точно %zu, в допуске %zu (до %d уровней), поток %zu байт\n",
+         r.run.frames.size(), same, close, worst, stream.size());
+  if (exact) {
+    CHECK_EQ(same, want.hashes.size());
+    CHECK(r.scnOk);
+  }
+  return report("frame_hash");
+}
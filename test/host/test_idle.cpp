@@ -0,0 +1,105 @@
+// Экономный режим демо: без нажатий IDLE_AFTER_MS — тусклее и реже
+// кадры, нажатие сразу будит и стартует матч. Нажатие, записанное позже, чем loop()
+// прочитал время, не должно усыплять плату.
+// Нажатие посреди light sleep будит по уровню на пине: от фронта до конца
+// передачи первого кадра — меньше WAKE_LIMIT_US. Вариант idle_power_log
+// (POWER_LOG=1) разбирает поминутные строки PWR: awake
+#include SKETCH
+#include "host.h"
+
+using namespace host;
+
+namespace {
+
+constexpr uint64_t WAKE_LIMIT_US = 20000;
+
+uint64_t firstShowUs = 0;
+
+void onFrame() {
+  if (!firstShowUs) firstShowUs = clockUs();
+}
+
+// "PWR: awake N% idle=I"
+struct AwakeLine {
+  int percent;
+  int idle;
+};
+
+std::vector<AwakeLine> awakeLines() {
+  std::vector<AwakeLine> res;
+  for (const std::string &line : lines("PWR: awake ")) {
+    AwakeLine a{ -1, -1 };
+    CHECK_EQ(sscanf(line.c_str(), "PWR: awake %d%% idle=%d", &a.percent, &a.idle), 2);
+    res.push_back(a);
+  }
+  return res;
+}
+
+void checkPowerLog() {
+  // Первая минута — без сна, вторая — целиком в экономном режиме
+  runUntil(2 * 60000UL + 100);
+  std::vector<AwakeLine> log = awakeLines();
+  CHECK_EQ(log.size(), 2u);
+  if (log.size() < 2) return;
+  CHECK_EQ(log[0].percent, 100);
+  CHECK_EQ(log[0].idle, 0);
+  CHECK_EQ(log[1].idle, 1);
+  CHECK(log[1].percent >= 0 && log[1].percent <= 10);
+  printf("awake: %d%% active, %d%% idle\n", log[0].percent, log[1].percent);
+  CHECK_EQ(lines("PWR: idle").size(), 1u);
+  CHECK(lines("PWR: wake").empty());
+}
+
+// Фронт кнопки посреди сна между кадрами демо
+void checkWakeLatency() {
+  modelWire = true;
+  const int sleepsBefore = sleeps;
+  const uint64_t pressUs = clockUs() + IDLE_DEMO_DELAY * 1000 / 2 + 137;
+  setPinAt(pressUs, buttonPin(1, 'R'), LOW);
+  firstShowUs = 0;
+  onShow = nullptr;
+  while (clockUs() < pressUs) tick();
+  CHECK(sleeps > sleepsBefore);
+  // Сон кончился фронтом: до таймера кадра оставалось полпериода, а
+  // после пробуждения прошёл только остаток tick()
+  CHECK(clockUs() <= pressUs + 1000);
+  onShow = onFrame;
+  for (int k = 0; k < 100 && !firstShowUs; k++) tick();
+  onShow = nullptr;
+  run(60);
+  release(1, 'R');
+  modelWire = false;
+
+  CHECK(firstShowUs > pressUs);
+  const uint64_t latencyUs = firstShowUs - pressUs;
+  printf("wake: press to first frame %" PRIu64 " us (limit %" PRIu64 ")\n", latencyUs, WAKE_LIMIT_US);
+  CHECK(latencyUs < WAKE_LIMIT_US);
+}
+
+}  // namespace
+
+int main() {
+  bootBoard();
+  CHECK(!power.idle);
+
+  run(IDLE_AFTER_MS + 200);
+  CHECK(power.idle);
+  CHECK_EQ(FastLED.getBrightness(), IDLE_BRIGHTNESS);
+  CHECK(sleeps > 0);
+  if (POWER_LOG) checkPowerLog();
+
+  checkWakeLatency();
+  CHECK(!power.idle);
+  CHECK_EQ(globalState, G_START_FILL);
+  if (POWER_LOG) CHECK_EQ(lines("PWR: wake").size(), 1u);
+  for (int k = 0; k < 120000 && globalState != G_DEMO; k++) tick();
+  CHECK_EQ(globalState, G_DEMO);
+
+  // lastInputMs на миллисекунду новее времени, с которым вызван updateIdle
+  unsigned long now = millis();
+  lastInputMs = now + 1;
+  updateIdle(now);
+  CHECK(!power.idle);
+  CHECK_EQ(FastLED.getBrightness(), BRIGHTNESS);
+  return report("idle");
+}
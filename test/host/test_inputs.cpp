@@ -0,0 +1,114 @@
+// Кнопки через расширители: тест собирается с INPUT_SOURCE InShift165
+// (цепочка 74HC165 на SPI) и InMcp23017 (I2C). Шина поднимается на своих
+// пинах, каждая кнопка попадает в свою дорожку и сторону, и нажатие с
+// расширителя запускает матч. MCP23017 без ответа не даёт нажатий.
+// Варианты inputs_*_64 — 64 дорожки (8 расширителей, 16 байт цепочки):
+// тест печатает опросов в секунду по времени шины (host::modelBus) и
+// требует, чтобы полный опрос занимал не больше четверти кадра
+#include SKETCH
+#include "host.h"
+
+#include <chrono>
+
+using namespace host;
+
+namespace {
+
+constexpr bool MCP = std::is_same<INPUT_SOURCE, InMcp23017>::value;
+constexpr int MCP_CHIPS = InMcp23017::CHIPS;
+
+// Бит b = 2 * дорожка + сторона, низкий уровень — нажата
+void setButton(int b, bool down) {
+  uint8_t *port = MCP ? &mcp[b / 16].inputs[(b / 8) & 1] : &SPI.in[b / 8];
+  if (down) *port &= ~(1 << (b & 7));
+  else *port |= 1 << (b & 7);
+}
+
+void checkBus() {
+  if (MCP) {
+    CHECK(Wire.started);
+    CHECK_EQ(Wire.sdaPin, MCP_SDA_PIN);
+    CHECK_EQ(Wire.sclPin, MCP_SCL_PIN);
+    CHECK_EQ(Wire.clock, MCP_I2C_HZ);
+    for (int p : {Wire.sdaPin, Wire.sclPin}) {
+      CHECK(p != SOUND_PIN);
+      CHECK(p != HAPTIC_PIN);
+    }
+    for (int c = 0; c < MCP_CHIPS; c++) {
+      CHECK_EQ(mcp[c].reg[0x0C], 0xFF);
+      CHECK_EQ(mcp[c].reg[0x0D], 0xFF);
+    }
+  } else {
+    CHECK_EQ(SPI.sckPin, SHIFT_CLK_PIN);
+    CHECK_EQ(SPI.misoPin, SHIFT_DATA_PIN);
+    CHECK_EQ(SPI.settings.hz, SHIFT_SPI_HZ);
+    CHECK_EQ(SPI.settings.order, LSBFIRST);
+  }
+}
+
+// Каждая кнопка по отдельности защёлкивает ровно свою дорожку и сторону
+void checkEachButton() {
+  for (int b = 0; b < BTN_BITS; b++) {
+    clearInputs();
+    setButton(b, true);
+    pollInputs();
+    for (int s = 0; s < NUM_STRIPS; s++) {
+      CHECK_EQ(btnL[s].pressed, b == 2 * s);
+      CHECK_EQ(btnR[s].pressed, b == 2 * s + 1);
+    }
+    setButton(b, false);
+    pollInputs();
+  }
+  clearInputs();
+}
+
+// Опросов в секунду: по времени шины и по процессору хоста
+void checkScanRate() {
+  constexpr int SCANS = 2000;
+  modelBus = true;
+  const unsigned long t0 = micros();
+  for (int k = 0; k < SCANS; k++) pollInputs();
+  const double scanUs = (double)(micros() - t0) / SCANS;
+  modelBus = false;
+
+  auto h0 = std::chrono::steady_clock::now();
+  for (int k = 0; k < SCANS; k++) pollInputs();
+  const double hostUs =
+    std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - h0).count() / SCANS;
+
+  printf("%d дорожек, %d кнопок: шина %.0f мкс на опрос, %.0f опросов/с (хост %.2f мкс)\n", NUM_STRIPS, BTN_BITS,
+         scanUs, 1e6 / scanUs, hostUs);
+  CHECK(scanUs > 0);
+  CHECK(scanUs * 4 <= GAME_DELAY * 1000);
+}
+
+}  // namespace
+
+int main() {
+  memset(SPI.in, 0xFF, sizeof(SPI.in));
+  for (int c = 0; c < 8; c++) mcp[c].present = c < MCP_CHIPS;
+  bootBoard();
+  run(500);
+  CHECK_EQ(globalState, G_DEMO);
+
+  checkBus();
+  checkEachButton();
+  checkScanRate();
+
+  if (MCP) {
+    // Расширитель не отвечает: его кнопки не нажаты, а не все разом
+    mcp[0].present = false;
+    setButton(0, true);
+    pollInputs();
+    CHECK(!btnL[0].pressed);
+    setButton(0, false);
+    mcp[0].present = true;
+  }
+
+  setButton(0, true);
+  run(60);
+  setButton(0, false);
+  for (int k = 0; k < 5000 && globalState != G_PLAYING; k++) tick();
+  CHECK_EQ(globalState, G_PLAYING);
+  return report(MCP ? "inputs_mcp23017" : "inputs_shift165");
+}
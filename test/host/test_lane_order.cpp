@@ -0,0 +1,106 @@
+// Кадр не зависит от порядка обновления дорожек: ModeHandoff с мячами,
+// переходящими между дорожками, и одинаковыми случайными нажатиями
+// прогоняется при разных laneOrder; хеш всех показанных кадров должен
+// совпасть с прямым порядком. Каждый порядок — в fork() от загруженной платы
+#include SKETCH
+#include "host.h"
+
+#include <algorithm>
+#include <random>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace host;
+
+namespace {
+
+constexpr unsigned long PLAY_MS = 30000;
+
+uint64_t framesHash = 0;
+unsigned frames = 0;
+unsigned visitors = 0;   // кадров, где на какой-то дорожке мяч-гость
+
+void foldFrame() {
+  framesHash = framesHash * 1099511628211ULL ^ frameHash64((const uint8_t *)leds, sizeof(leds));
+  frames++;
+  for (int s = 0; s < NUM_STRIPS; s++)
+    for (int k = 0; k < pools[s].count; k++)
+      if (pools[s].obj[k].visitor) {
+        visitors++;
+        return;
+      }
+}
+
+void play() {
+  onShow = foldFrame;
+  press(0, 'L');
+  std::mt19937 rng(41);
+  const unsigned long until = millis() + PLAY_MS;
+  while (millis() < until) {
+    int b = rng() % (2 * NUM_STRIPS);
+    int pin = buttonPin(b / 2, (b & 1) ? 'R' : 'L');
+    setPin(pin, !pins[pin]);
+    run(rng() % 200);
+  }
+}
+
+struct Result {
+  uint64_t hash;
+  unsigned frames, visitors, faults;
+};
+
+Result runOrder(const uint8_t *order) {
+  int fd[2];
+  if (pipe(fd) != 0) abort();
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0) {
+    close(fd[0]);
+    memcpy(laneOrder, order, NUM_STRIPS);
+    play();
+    Result r{framesHash, frames, visitors, invariantFaults};
+    if (write(fd[1], &r, sizeof(r)) != (ssize_t)sizeof(r)) _exit(1);
+    _exit(0);
+  }
+  close(fd[1]);
+  Result r{};
+  if (read(fd[0], &r, sizeof(r)) != (ssize_t)sizeof(r)) r.frames = 0;
+  close(fd[0]);
+  int status = 0;
+  waitpid(pid, &status, 0);
+  return r;
+}
+
+}  // namespace
+
+int main() {
+  bootBoard();
+
+  std::vector<std::vector<uint8_t>> orders;
+  std::vector<uint8_t> o(NUM_STRIPS);
+  for (int s = 0; s < NUM_STRIPS; s++) o[s] = s;
+  orders.push_back(o);
+  std::reverse(o.begin(), o.end());
+  orders.push_back(o);
+  std::mt19937 rng(7);
+  for (int k = 0; k < 6; k++) {
+    std::shuffle(o.begin(), o.end(), rng);
+    orders.push_back(o);
+  }
+
+  Result first = runOrder(orders[0].data());
+  CHECK(first.frames > 0);
+  CHECK(first.visitors > 0);
+  CHECK_EQ(first.faults, 0);
+  for (size_t k = 1; k < orders.size(); k++) {
+    Result r = runOrder(orders[k].data());
+    std::string name;
+    for (uint8_t s : orders[k]) name += char('0' + s);
+    printf("order %s: %u frames, hash %016" PRIx64 "\n", name.c_str(), r.frames, r.hash);
+    CHECK_EQ(r.frames, first.frames);
+    CHECK(r.hash == first.hash);
+  }
+  printf("order 01234: %u frames, %u with visitors, hash %016" PRIx64 "\n", first.frames,
+         first.visitors, first.hash);
+  return report("lane_order");
+}
@@ -0,0 +1,102 @@
+// Гистограмма LATENCY_TEST против задержки, измеренной снаружи: фронт
+// BTN_L дорожки 0 подаётся через setPin (прерывание) посреди
+// миллисекунды между проходами loop(), show() занимает время передачи по проводу
+// (modelWire). Снаружи задержка — от фронта до конца показа кадра, в
+// котором дорожка приняла нажатие. Итоговый отчёт LAT: должен совпасть
+// с этой гистограммой по корзинам, минимум — не меньше передачи кадра
+#include SKETCH
+#include "host.h"
+
+#include <random>
+
+using namespace host;
+
+namespace {
+
+constexpr int REPORTS = 2;
+
+unsigned long edgeAt = 0;
+unsigned long seenButton = 0;
+bool armed = false;
+std::vector<unsigned long> measured;
+
+// Кадр, в котором handleButtons принял нажатие, кончил передачу сейчас
+void onFrameShown() {
+  if (globalState != G_PLAYING) {
+    armed = false;
+    return;
+  }
+  if (armed && game[0].lastButton != seenButton) measured.push_back(micros() - edgeAt);
+  armed = false;
+}
+
+// Фронт между проходами loop(): опрос увидит его до миллисекунды позже,
+// отсчёт идёт от прерывания
+void pressEdge(std::mt19937 &rng) {
+  unsigned long offset = 1 + rng() % 999;
+  edgeAt = micros() + offset;
+  advance(offset);
+  seenButton = game[0].lastButton;
+  armed = globalState == G_PLAYING;
+  hold(0, 'L');
+  advance(1000 - offset);
+  run(40);
+  release(0, 'L');
+}
+
+}  // namespace
+
+int main() {
+  modelWire = true;
+  onShow = onFrameShown;
+  bootBoard();
+  std::mt19937 rng(44);
+
+  for (int k = 0; k < 20000 && lines("LAT: n=").size() < REPORTS; k++) {
+    if (globalState == G_DEMO) {
+      press(0, 'L');
+      for (int w = 0; w < 5000 && globalState != G_PLAYING; w++) tick();
+      continue;
+    }
+    if (globalState != G_PLAYING) {
+      tick();
+      continue;
+    }
+    pressEdge(rng);
+    run(BUTTON_LOCKOUT + rng() % 200);
+  }
+  CHECK_EQ(lines("LAT: n=").size(), REPORTS);
+  CHECK_EQ(measured.size(), REPORTS * LATENCY_REPORT);
+
+  // Последний отчёт — накопленная гистограмма всех нажатий
+  std::vector<unsigned> want(LAT_BUCKETS), got(LAT_BUCKETS);
+  unsigned long lo = ~0UL, hi = 0;
+  for (unsigned long us : measured) {
+    want[std::min(us / LAT_BUCKET_US, (unsigned long)LAT_BUCKETS - 1)]++;
+    lo = std::min(lo, us);
+    hi = std::max(hi, us);
+  }
+  std::vector<std::string> lat = lines("LAT:");
+  size_t last = 0;
+  for (size_t k = 0; k < lat.size(); k++)
+    if (lat[k].compare(0, 7, "LAT: n=") == 0) last = k;
+  unsigned n = 0;
+  unsigned long mn = 0, mx = 0;
+  CHECK_EQ(sscanf(lat[last].c_str(), "LAT: n=%u min=%lu max=%lu us", &n, &mn, &mx), 3);
+  for (size_t k = last + 1; k < lat.size(); k++) {
+    unsigned from = 0, to = 0, count = 0;
+    if (sscanf(lat[k].c_str(), "LAT: %u-%u ms %u", &from, &to, &count) == 3)
+      got[from * 1000 / LAT_BUCKET_US] = count;
+  }
+  for (size_t k = last; k < lat.size(); k++) printf("%s\n", lat[k].c_str());
+
+  CHECK_EQ(n, measured.size());
+  CHECK_EQ(mn, lo);
+  CHECK_EQ(mx, hi);
+  for (int b = 0; b < LAT_BUCKETS; b++) CHECK_EQ(got[b], want[b]);
+
+  // Передача кадра входит в задержку; кадр логики — раз в GAME_DELAY
+  CHECK(lo >= WIRE_US);
+  CHECK(hi <= GAME_DELAY * 1000UL + WIRE_US + 2000);
+  return report("latency_hist");
+}
@@ -0,0 +1,50 @@
+// Нажатие оценивается по кадру, который игрок уже видел. Тест собирается
+// дважды: без задержки дисплея и с DISPLAY_EXTRA_US 60000 (два шага
+// мяча). Одно и то же нажатие через 5 мс после шага мяча в зону —
+// отбивание без задержки и промах с ней; с задержкой отбивает нажатие,
+// сделанное на DISPLAY_EXTRA_US позже
+#include SKETCH
+#include "host.h"
+
+using namespace host;
+
+// Зона сдвигается со счётом, поэтому её начало читается на каждом шаге
+static bool waitZoneEntry(int s) {
+  for (int k = 0; k < 20000; k++) {
+    tick();
+    const StripGame &g = game[s];
+    if (globalState == G_PLAYING && g.ballPos == g.zoneR && g.direction == DIR_RIGHT) return true;
+  }
+  return false;
+}
+
+// Нажатие правой кнопки дорожки 0 через lagMs после шага мяча на
+// первую клетку правой зоны. true — мяч отбит
+static bool pressAfterZoneEntry(unsigned long lagMs) {
+  StripGame &g = game[0];
+  CHECK(waitZoneEntry(0));
+  int scoreL = g.scoreL;
+  run(lagMs - 1);   // waitZoneEntry уже прошёл миллисекунду после кадра
+  hold(0, 'R');
+  run(GAME_DELAY + 1);
+  release(0, 'R');
+  bool hit = g.scoreL == scoreL && g.direction == DIR_LEFT;
+  printf("lag %lu ms: seen %s, grade %d\n", lagMs, hit ? "in zone" : "outside", g.lastGrade);
+  return hit;
+}
+
+int main() {
+  bootBoard();
+  press(0, 'L');
+  runUntil(millis() + 2000);
+  CHECK_EQ(globalState, G_PLAYING);
+
+  const unsigned long lag = 5;
+  if (DISPLAY_EXTRA_US == 0) {
+    CHECK(pressAfterZoneEntry(lag));
+  } else {
+    CHECK(!pressAfterZoneEntry(lag));
+    CHECK(pressAfterZoneEntry(lag + DISPLAY_EXTRA_US / 1000));
+  }
+  return report("latency_inject");
+}
@@ -0,0 +1,119 @@
+// ModeMultiBall: мяч, столкнувшийся с препятствием, встаёт перед ним со
+// своей стороны, а не в клетку, куда препятствие только что шагнуло;
+// занята и она — остаётся на месте. Дополнительный мяч при нажатии
+// оценивается там, где его видел игрок, а не там, где он уже есть.
+// После отскока пул снова отсортирован, и следующий шаг не принимает
+// перестановку за столкновение
+#include SKETCH
+#include "host.h"
+
+using namespace host;
+
+namespace {
+
+LaneObject &put(int s, ObjectKind kind, int pos, int dir) {
+  ObjectPool &p = pools[s];
+  LaneObject &o = p.obj[p.count++];
+  o = LaneObject{};
+  o.pos = o.shownPos = pos;
+  o.dir = dir;
+  o.kind = kind;
+  o.id = p.count - 1;
+  o.hitAt = -1;
+  return o;
+}
+
+const LaneObject *find(int s, ObjectKind kind) {
+  for (int k = 0; k < pools[s].count; k++)
+    if (pools[s].obj[k].kind == kind) return &pools[s].obj[k];
+  return nullptr;
+}
+
+// Объекты кладутся в пул в порядке до шага, с положениями после него
+void sweepCases() {
+  // Мяч 40 -> 41 и препятствие 41 -> 40 поменялись клетками
+  pools[0].count = 0;
+  put(0, OBJ_BALL, 41, DIR_RIGHT);
+  put(0, OBJ_OBSTACLE, 40, DIR_LEFT);
+  sweepObjects(0);
+  const LaneObject *ball = find(0, OBJ_BALL);
+  CHECK_EQ(ball->pos, 39);
+  CHECK_EQ(ball->dir, DIR_LEFT);
+  CHECK(!obstacleAt(0, ball->pos));
+  CHECK(pools[0].obj[0].pos <= pools[0].obj[1].pos);
+
+  // Следующий шаг: мяч уходит 39 -> 38 от стоящего препятствия, а не
+  // прыгает обратно через него
+  LaneObject *moving = const_cast<LaneObject *>(ball);
+  moving->pos += moving->dir;
+  sweepObjects(0);
+  ball = find(0, OBJ_BALL);
+  CHECK_EQ(ball->pos, 38);
+  CHECK_EQ(ball->dir, DIR_LEFT);
+
+  // Перед препятствием стоит другое — мяч остаётся, где был после шага
+  pools[0].count = 0;
+  put(0, OBJ_OBSTACLE, 39, DIR_RIGHT);
+  put(0, OBJ_BALL, 41, DIR_RIGHT);
+  put(0, OBJ_OBSTACLE, 40, DIR_LEFT);
+  sweepObjects(0);
+  ball = find(0, OBJ_BALL);
+  CHECK_EQ(ball->pos, 41);
+  CHECK_EQ(ball->dir, DIR_LEFT);
+  CHECK(!obstacleAt(0, ball->pos));
+
+  // Мяч 31 -> 30 навстречу препятствиям 29 -> 30 и 30 -> 31:
+  // отскок от первого на пути, того, что теперь в 31
+  pools[0].count = 0;
+  put(0, OBJ_OBSTACLE, 30, DIR_RIGHT);
+  put(0, OBJ_OBSTACLE, 31, DIR_RIGHT);
+  put(0, OBJ_BALL, 30, DIR_LEFT);
+  sweepObjects(0);
+  ball = find(0, OBJ_BALL);
+  CHECK_EQ(ball->pos, 32);
+  CHECK_EQ(ball->dir, DIR_RIGHT);
+  CHECK(!obstacleAt(0, ball->pos));
+}
+
+// Кадр с объектами на местах shownPos становится видимым; время, когда его видно
+unsigned long showObjects() {
+  unsigned long now = micros();
+  recordShownFrame(now, now, now);
+  return frameHistory[frameHead].visibleAtUs;
+}
+
+void seenCases() {
+  press(0, 'L');
+  for (int k = 0; k < 5000 && globalState != G_PLAYING; k++) tick();
+  CHECK_EQ(globalState, G_PLAYING);
+
+  StripGame &g = game[0];
+  pools[0].count = 0;
+  LaneObject &a = put(0, OBJ_BALL, g.zoneL + 1, DIR_LEFT);
+  LaneObject &b = put(0, OBJ_BALL, NUM_LEDS / 2, DIR_LEFT);
+  unsigned long seenAt = showObjects();
+
+  // a виден в зоне, но с тех пор ушёл: отбивается
+  a.pos = NUM_LEDS / 2 + 3;
+  CHECK(hitExtraBall(0, DIR_RIGHT, seenAt) != HIT_MISS);
+  CHECK_EQ(a.dir, DIR_RIGHT);
+
+  // b уже в зоне, но игрок видел его в середине: промах
+  b.pos = g.zoneL + 1;
+  CHECK_EQ(hitExtraBall(0, DIR_RIGHT, seenAt), HIT_MISS);
+  CHECK_EQ(b.dir, DIR_LEFT);
+
+  // Новый мяч, которого в видимом кадре не было, не отбивается
+  pools[0].count = 1;
+  addObject(0, OBJ_BALL, g.zoneL + 1, DIR_LEFT, true);
+  CHECK_EQ(hitExtraBall(0, DIR_RIGHT, seenAt), HIT_MISS);
+}
+
+}  // namespace
+
+int main() {
+  bootBoard();
+  sweepCases();
+  seenCases();
+  return report("objects");
+}
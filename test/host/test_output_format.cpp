@@ -0,0 +1,29 @@
+// Формат строки OUT:. Она печатает измеренный показ первого кадра, а не оценку по
+// WIRE_NS_PER_LED: ленты, показ которых медленнее оценки (программный
+// SPI у OutClocked), дают меньший предел частоты кадров
+#include SKETCH
+#include "host.h"
+
+using namespace host;
+
+constexpr unsigned long SLOW_US = 7000;   // сверх времени передачи по проводу
+
+int main() {
+  modelWire = true;
+  showCostUs = SLOW_US;
+  bootBoard();
+
+  std::vector<std::string> out = lines("OUT:");
+  CHECK_EQ(out.size(), 1);
+  if (out.empty()) return report("output_format");
+  printf("%s\n", out[0].c_str());
+
+  unsigned long show = 0, fps = 0, wire = 0;
+  size_t at = out[0].find(" show ");
+  CHECK(at != std::string::npos);
+  CHECK_EQ(sscanf(out[0].c_str() + at, " show %lu us, max %lu fps (wire estimate %lu us)", &show, &fps, &wire), 3);
+  CHECK_EQ(wire, WIRE_US);
+  CHECK_EQ(show, WIRE_US + SLOW_US);
+  CHECK_EQ(fps, 1000000UL / (WIRE_US + SLOW_US));
+  return report("output_format");
+}
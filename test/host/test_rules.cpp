@@ -0,0 +1,45 @@
+// Профиль правил из Serial: значения вне диапазона поля отбрасываются
+// целиком, а не сужаются (RULES 259 не становится hitZone 3)
+#include SKETCH
+#include "host.h"
+
+using namespace host;
+
+// true — строка принята в очередь
+static bool send(const char *line) {
+  rulesPending = false;
+  size_t before = lines("RULES: pending").size();
+  Serial.feed(line);
+  Serial.feed("\n");
+  run(2);
+  return lines("RULES: pending").size() > before;
+}
+
+int main() {
+  bootBoard();
+
+  // 5 дорожек по 108: barCache 2 * 54 * 3 + 5 * 3, слоты 5 * 5 * 3 + 5
+  CHECK_EQ(lines("PALETTE: score colors 80 B, barCache was 339 B").size(), 1);
+
+  CHECK(send("RULES 3 10 50 30 008000 0000FF FFFFFF"));
+  CHECK_EQ(pendingRules.hitZone, 3);
+
+  CHECK(!send("RULES 259 10 50 30 008000 0000FF FFFFFF"));   // uint8_t
+  CHECK(!send("RULES 3 266 50 30 008000 0000FF FFFFFF"));
+  CHECK(!send("RULES 3 10 65586 30 008000 0000FF FFFFFF"));  // uint16_t
+  CHECK(!send("RULES 3 10 50 65566 008000 0000FF FFFFFF"));
+  CHECK(!send("RULES -1 10 50 30 008000 0000FF FFFFFF"));    // strtoul: ULONG_MAX
+  CHECK(!send("RULES 3 10 50 30 -008000 0000FF FFFFFF"));
+  CHECK(!send("RULES 3 10 50 30 1008000 0000FF FFFFFF"));    // больше RRGGBB
+  CHECK(!send("RULES 3 10 50 30 008000 0000FF 99999999999999999999"));
+  CHECK(!send("RULES 3 10 50 30 008000 0000FF"));
+
+  CHECK(send("PALETTE 1 2 3 0 1"));
+  CHECK_EQ(pendingRules.lanePalette[2], 3);
+  CHECK(!send("PALETTE 1 2 3 0 257"));                       // 257 -> 1 при сужении
+  CHECK(!send("PALETTE 1 2 3 0 4"));
+  CHECK(!send("PALETTE 1 2 -3 0 1"));
+
+  CHECK_EQ(rules.hitZone, HIT_ZONE);   // в демо очередь применяется только при старте
+  return report("rules");
+}
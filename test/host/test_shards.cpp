@@ -0,0 +1,196 @@
+// Шкаф из трёх плат в отдельных процессах: ведущая и две ведомые
+// (board_main) на настоящих часах, SHARD_UART каждой — свой PTY. Тест —
+// общая шина RS-485: байты любой платы уходят всем остальным, и каждый
+// BUS_NOISE-й байт портится. Часы ведомых идут быстрее и медленнее
+// ведущей и сдвинуты на секунды. Нажатие на ведомой в демо запускает
+// матч; все платы проходят демо -> заполнение -> игра -> конец -> демо,
+// входят в игру почти одновременно, а время игры ведомых совпадает с
+// ведущей с точностью до нескольких мс.
+//   shards <board_master> <board_slave1> <board_slave2>
+#include SKETCH
+#include "host.h"
+
+#include <poll.h>
+#include <pty.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace host;
+
+namespace {
+
+constexpr int BOARDS = 3;
+constexpr const char *RUN_MS = "14000";
+constexpr int BUS_NOISE = 400;
+constexpr long PHASE_TOLERANCE_MS = 8;
+constexpr long ENTRY_TOLERANCE_MS = 150;
+
+struct Board {
+  Board(const char *exe, const char *rate, const char *offsetMs, const char *press)
+      : exe(exe), rate(rate), offsetMs(offsetMs), press(press) {}
+
+  const char *exe;
+  const char *rate;
+  const char *offsetMs;
+  const char *press;
+  int uart = -1;           // сторона PTY у шины
+  int out = -1;            // stdout платы
+  pid_t pid = -1;
+  std::string text;        // stdout целиком
+  std::string partial;
+  std::vector<std::pair<std::string, long long>> lines;   // строка и когда пришла
+};
+
+long long monotonicMs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+bool start(Board &b) {
+  termios raw;
+  memset(&raw, 0, sizeof(raw));
+  cfmakeraw(&raw);
+  int bus, dev;
+  char name[64];
+  if (openpty(&bus, &dev, name, &raw, nullptr) != 0) return false;
+  int pipeFd[2];
+  if (pipe(pipeFd) != 0) return false;
+
+  b.pid = fork();
+  if (b.pid == 0) {
+    dup2(pipeFd[1], STDOUT_FILENO);
+    close(pipeFd[0]);
+    close(bus);
+    std::vector<const char *> args = { b.exe, name, RUN_MS, b.rate, b.offsetMs };
+    if (b.press) args.push_back(b.press);
+    args.push_back(nullptr);
+    execv(b.exe, (char *const *)args.data());
+    _exit(127);
+  }
+  close(pipeFd[1]);
+  close(dev);
+  b.uart = bus;
+  b.out = pipeFd[0];
+  return true;
+}
+
+void collect(Board &b, const char *p, ssize_t n) {
+  b.text.append(p, n);
+  b.partial.append(p, n);
+  size_t at;
+  while ((at = b.partial.find('\n')) != std::string::npos) {
+    std::string line = b.partial.substr(0, at);
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    b.lines.emplace_back(line, monotonicMs());
+    b.partial.erase(0, at + 1);
+  }
+}
+
+// Шина: байты платы k — остальным, BUS_NOISE-й байт с одним битом наоборот
+int relay(Board *boards) {
+  int corrupted = 0;
+  unsigned long bytes = 0;
+  int open = BOARDS;
+  while (open > 0) {
+    pollfd fds[2 * BOARDS];
+    for (int k = 0; k < BOARDS; k++) {
+      fds[k] = { boards[k].uart, POLLIN, 0 };
+      fds[BOARDS + k] = { boards[k].out, POLLIN, 0 };
+    }
+    if (poll(fds, 2 * BOARDS, 1000) < 0) break;
+
+    for (int k = 0; k < BOARDS; k++) {
+      char buf[512];
+      if (fds[k].revents & POLLIN) {
+        ssize_t n = read(boards[k].uart, buf, sizeof(buf));
+        for (ssize_t i = 0; i < n; i++)
+          if (++bytes % BUS_NOISE == 0) {
+            buf[i] ^= 1 << (bytes / BUS_NOISE % 8);
+            corrupted++;
+          }
+        for (int j = 0; j < BOARDS && n > 0; j++)
+          if (j != k && write(boards[j].uart, buf, n) != n) fprintf(stderr, "shards: шина переполнена\n");
+      }
+      if (fds[BOARDS + k].revents & (POLLIN | POLLHUP)) {
+        ssize_t n = read(boards[k].out, buf, sizeof(buf));
+        if (n > 0) {
+          collect(boards[k], buf, n);
+        } else if (boards[k].out >= 0) {
+          close(boards[k].out);
+          boards[k].out = -1;
+          open--;
+        }
+      }
+    }
+  }
+  return corrupted;
+}
+
+// Когда плата перешла в состояние to (по времени шины), -1 — не перешла
+long long entered(const Board &b, int to, long long after = 0) {
+  char want[16];
+  snprintf(want, sizeof(want), "-> %d @", to);
+  for (const auto &l : b.lines)
+    if (l.first.compare(0, 7, "STATE: ") == 0 && l.first.find(want) != std::string::npos && l.second >= after)
+      return l.second;
+  return -1;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (argc != 1 + BOARDS) {
+    fprintf(stderr, "shards <board_master> <board_slave1> <board_slave2>\n");
+    return 2;
+  }
+  signal(SIGPIPE, SIG_IGN);
+  Board boards[BOARDS] = {
+    { argv[1], "1.0", "0", nullptr },
+    { argv[2], "1.002", "5000", "0L@1500" },   // часы спешат, кнопка на ведомой
+    { argv[3], "0.998", "2000", nullptr },     // отстают
+  };
+  const long long t0 = monotonicMs();
+  for (Board &b : boards) CHECK(start(b));
+  int corrupted = relay(boards);
+
+  long long phase[BOARDS] = {};
+  for (int k = 0; k < BOARDS; k++) {
+    Board &b = boards[k];
+    int status = 0;
+    waitpid(b.pid, &status, 0);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    close(b.uart);
+
+    int shard = -1, state = -1;
+    size_t at = b.text.find("BOARD: ");
+    CHECK(at != std::string::npos);
+    if (at != std::string::npos)
+      CHECK_EQ(sscanf(b.text.c_str() + at, "BOARD: shard %d state %d game-mono %lld", &shard, &state, &phase[k]), 3);
+    CHECK_EQ(shard, k);
+    CHECK_EQ(state, G_DEMO);
+    CHECK(b.text.find("INV:") == std::string::npos);
+  }
+
+  // Весь цикл матча на каждой плате, по порядку
+  long long playing[BOARDS];
+  for (int k = 0; k < BOARDS; k++) {
+    long long fill = entered(boards[k], G_START_FILL);
+    playing[k] = entered(boards[k], G_PLAYING, fill);
+    long long over = entered(boards[k], G_GAME_OVER_ANIM, playing[k]);
+    long long demo = entered(boards[k], G_DEMO, over);
+    printf("board %d: fill %lld, playing %lld, game over %lld, demo %lld ms, phase %lld ms\n", k,
+           fill - t0, playing[k] - t0, over - t0, demo - t0, phase[k] - phase[0]);
+    CHECK(fill >= 0 && playing[k] >= 0 && over >= 0 && demo >= 0);
+  }
+  for (int k = 1; k < BOARDS; k++) {
+    CHECK(llabs(playing[k] - playing[0]) <= ENTRY_TOLERANCE_MS);
+    CHECK(llabs(phase[k] - phase[0]) <= PHASE_TOLERANCE_MS);
+  }
+  CHECK(corrupted > 0);
+  printf("shards: испорчено байт на шине %d\n", corrupted);
+  return report("shards");
+}
@@ -0,0 +1,37 @@
+// Очередь звуковых событий между двумя ядрами: игра кладёт события из
+// основного потока, проигрыватель на втором потоке разбирает их, как
+// задача на ядре 0. Собирается с ThreadSanitizer: гонка на ячейках
+// очереди или индексах — отчёт TSan и ненулевой код выхода. Каждое
+// событие либо прозвучало (tone), либо отброшено и посчитано
+#include SKETCH
+#include "host.h"
+
+#include <atomic>
+#include <thread>
+
+using namespace host;
+
+int main() {
+  setup();
+  const unsigned long now = millis();   // одно время: события не устаревают
+  std::atomic<bool> stop(false);
+
+  std::thread reader([&] {
+    while (!stop.load(std::memory_order_acquire)) soundTick(now);
+    soundTick(now);
+  });
+
+  const int posted = 5000;
+  for (int k = 0; k < posted; k++) {
+    uint16_t dropped = soundDropped;
+    postSound((SoundCue)(k % CUE_COUNT));
+    if (soundDropped != dropped) std::this_thread::yield();   // очередь полна: дать место читателю
+  }
+  stop.store(true, std::memory_order_release);
+  reader.join();
+
+  printf("posted %d, played %d, dropped %u\n", posted, tones, (unsigned)soundDropped);
+  CHECK(tones > 0);
+  CHECK_EQ(tones + soundDropped, posted);
+  return report("sound_ring");
+}
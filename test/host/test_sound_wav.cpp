@@ -0,0 +1,152 @@
+// Звук против кадров. Проигрыватель (на плате задача ядра 0) опрашивается
+// каждую миллисекунду, tone()/noTone() пишутся в журнал хоста и сводятся
+// в sound.wav. Матч: дорожка 0 первые BOT_MS отбивает, остальные пропускают.
+// Начало каждого сигнала должно попасть в кадр, где видно его событие:
+// промах — сменился счёт, отбивание — развернулся шарик, старт — начало
+// заполнения. Допуск — кадр (GAME_DELAY) и передача ленты.
+// WAV читается обратно: в начале каждой ноты частота по переходам через
+// ноль совпадает с журналом
+#include SKETCH
+#include "host.h"
+
+#include <fstream>
+#include <iterator>
+
+using namespace host;
+
+namespace {
+
+struct Shown {
+  uint64_t us;
+  GlobalState state;
+  int score[NUM_STRIPS];
+  int8_t dir[NUM_STRIPS];
+};
+
+std::vector<Shown> frames;
+
+void onFrame() {
+  Shown f{ clockUs(), globalState, {}, {} };
+  for (int s = 0; s < NUM_STRIPS; s++) {
+    f.score[s] = game[s].scoreL + game[s].scoreR;
+    f.dir[s] = game[s].direction;
+  }
+  frames.push_back(f);
+}
+
+enum Kind { K_START, K_MISS, K_HIT, K_NONE };
+
+// Сигнал по первой ноте
+Kind kindOf(unsigned freq) {
+  if (freq == pgm_read_word(&NOTES_START[0].freq)) return K_START;
+  if (freq == pgm_read_word(&NOTES_MISS[0].freq)) return K_MISS;
+  if (freq == pgm_read_word(&NOTES_HIT[0].freq) || freq == pgm_read_word(&NOTES_PERFECT[0].freq)) return K_HIT;
+  return K_NONE;
+}
+
+// Кадр k показал событие вида kind (по сравнению с кадром k - 1)
+bool frameShows(size_t k, Kind kind) {
+  const Shown &a = frames[k - 1], &b = frames[k];
+  if (kind == K_START) return a.state != G_START_FILL && b.state == G_START_FILL;
+  for (int s = 0; s < NUM_STRIPS; s++) {
+    if (kind == K_MISS && b.score[s] > a.score[s]) return true;
+    if (kind == K_HIT && b.score[s] == a.score[s] && b.dir[s] != a.dir[s]) return true;
+  }
+  return false;
+}
+
+// Миллисекунда платы вместе с задачей проигрывателя
+void tickWithSound() {
+  tick();
+  soundTick(millis());
+}
+
+void pressWithSound(int lane, char side, unsigned long ms) {
+  hold(lane, side);
+  for (unsigned long k = 0; k < ms; k++) tickWithSound();
+  release(lane, side);
+}
+
+// Дорожка 0 жмёт, когда шарик в середине её зоны и летит к ней, первые
+// BOT_MS матча; потом пропускает, и матч кончается
+constexpr unsigned long BOT_MS = 20000;
+
+void botTick(unsigned long since) {
+  const StripGame &g = game[0];
+  if (globalState != G_PLAYING || g.state != PLAYING || millis() - since > BOT_MS) return;
+  int mid = g.direction == DIR_LEFT ? g.zoneL + g.hitZone / 2 : g.zoneR + g.hitZone / 2;
+  if (g.ballPos == mid) pressWithSound(0, g.direction == DIR_LEFT ? 'L' : 'R', 20);
+}
+
+}  // namespace
+
+int main() {
+  modelWire = true;
+  onShow = onFrame;
+  bootBoard();
+  for (int k = 0; k < 500; k++) tickWithSound();
+  const unsigned long start = millis();
+  pressWithSound(0, 'L', 60);
+  for (int k = 0; k < 300000 && (globalState != G_DEMO || millis() - start < 3000); k++) {
+    botTick(start);
+    tickWithSound();
+  }
+  CHECK_EQ(globalState, G_DEMO);
+  CHECK(writeWav("sound.wav"));
+
+  // Начала сигналов против кадров
+  const uint64_t slackUs = GAME_DELAY * 1000ULL + (uint64_t)NUM_LEDS * LED_OUTPUT::WIRE_NS_PER_LED / 1000 + 1000;
+  int onsets[K_NONE] = {}, late = 0;
+  uint64_t worstUs = 0;
+  for (size_t e = 0; e < toneLog.size(); e++) {
+    Kind kind = kindOf(toneLog[e].freq);
+    if (kind == K_NONE || (e > 0 && toneLog[e - 1].us == toneLog[e].us && toneLog[e - 1].freq == toneLog[e].freq))
+      continue;
+    onsets[kind]++;
+    uint64_t best = UINT64_MAX;
+    for (size_t k = 1; k < frames.size(); k++) {
+      if (!frameShows(k, kind)) continue;
+      uint64_t d = frames[k].us > toneLog[e].us ? frames[k].us - toneLog[e].us : toneLog[e].us - frames[k].us;
+      best = min(best, d);
+    }
+    worstUs = max(worstUs, best);
+    if (best > slackUs) {
+      if (late++ < 5) printf("сигнал %u Гц в %llu мкс: ближайший кадр события через %llu мкс\n", toneLog[e].freq,
+                             (unsigned long long)toneLog[e].us, (unsigned long long)best);
+    }
+  }
+  printf("кадров %zu, смен звука %zu; старт %d, промахов %d, отбиваний %d; расхождение до %.1f мс (допуск %.1f)\n",
+         frames.size(), toneLog.size(), onsets[K_START], onsets[K_MISS], onsets[K_HIT], worstUs / 1000.0,
+         slackUs / 1000.0);
+  CHECK(onsets[K_START] >= 1);
+  CHECK(onsets[K_MISS] >= 1);
+  CHECK(onsets[K_HIT] >= 1);
+  CHECK_EQ(late, 0);
+
+  // WAV: 16 кГц, 16 бит моно после 44 байт заголовка
+  std::ifstream in("sound.wav", std::ios::binary);
+  std::string wav((std::istreambuf_iterator<char>(in)), {});
+  CHECK(wav.size() > 44 && wav.compare(0, 4, "RIFF") == 0 && wav.compare(8, 4, "WAVE") == 0);
+  const int16_t *pcm = (const int16_t *)(wav.data() + 44);
+  const size_t samples = (wav.size() - 44) / 2;
+  const uint64_t startUs = toneLog.front().us;
+  int notes = 0, wrong = 0;
+  for (size_t e = 0; e + 1 < toneLog.size(); e++) {
+    const unsigned freq = toneLog[e].freq;
+    const uint64_t durUs = toneLog[e + 1].us - toneLog[e].us;
+    if (!freq || durUs < 20000) continue;
+    size_t from = (toneLog[e].us - startUs) * 16000 / 1000000, len = 16000 * 20 / 1000;
+    if (from + len >= samples) break;
+    int crossings = 0;
+    for (size_t n = from + 1; n < from + len; n++) crossings += (pcm[n] < 0) != (pcm[n - 1] < 0);
+    double got = crossings / 2.0 / 0.020;
+    notes++;
+    if (fabs(got - freq) > freq * 0.1 + 50) {
+      if (wrong++ < 5) printf("нота %u Гц: в WAV %.0f Гц\n", freq, got);
+    }
+  }
+  printf("sound.wav: %zu отсчётов, проверено нот %d\n", samples, notes);
+  CHECK(notes > 0);
+  CHECK_EQ(wrong, 0);
+  return report("sound_wav");
+}
@@ -0,0 +1,88 @@
+// Профили прежних скетчей (VARIANT 1-3): собираются, берут свои правила
+// и режим и доигрывают матч без нажатий до демо. Очко прибавляет
+// SCORE_STEP, у ModeClassic зона не сдвигается со счётом.
+// Профиль выбирает и прежний вид: конец матча без мигания — дорожки
+// держат цвет своего победителя (OVER_HOLD), но через время мигания
+// плата возвращается в демо, а не ждёт сброса; у 2main/3main/4main демо —
+// комета (DEMO_COMET). У 1main демо не было, у него общее дыхание
+#include SKETCH
+#include "host.h"
+
+using namespace host;
+
+namespace {
+
+bool lit(const CRGB &c) { return c.r || c.g || c.b; }
+
+// Дыхание — вся дорожка одного цвета; комета — голова и хвост не
+// длиннее DEMO_COMET_LEN
+void checkDemo() {
+  run(DEMO_DELAY * 30);
+  int on = 0;
+  bool uniform = true;
+  for (int i = 0; i < NUM_LEDS; i++) {
+    on += lit(pixel(0, i));
+    uniform &= pixel(0, i) == pixel(0, 0);
+  }
+  if (DEMO_STYLE == DEMO_COMET) {
+    CHECK(on >= 2 && on <= DEMO_COMET_LEN);
+    CHECK(!uniform);
+  } else {
+    CHECK(uniform);
+    CHECK_EQ(on, NUM_LEDS);
+  }
+}
+
+// Конец матча: мигание гасит дорожки, OVER_HOLD держит цвет победителя
+// дорожки до самого демо
+void checkMatchEnd(CRGB winner) {
+  const unsigned long overAt = millis();
+  bool blackSeen = false, winnerHeld = true;
+  while (globalState == G_GAME_OVER_ANIM) {
+    tick();
+    if (globalState != G_GAME_OVER_ANIM) break;
+    blackSeen |= !lit(pixel(0, NUM_LEDS / 2));
+    winnerHeld &= pixel(0, NUM_LEDS / 2) == winner;
+  }
+  CHECK(millis() - overAt >= BLINK_DELAY * BLINK_TOGGLES);
+  CHECK_EQ(blackSeen, OVER_STYLE == OVER_BLINK);
+  if (OVER_STYLE == OVER_HOLD) CHECK(winnerHeld);
+}
+
+}  // namespace
+
+int main() {
+  bootBoard();
+  checkDemo();
+  CHECK_EQ(rules.scoreStep, SCORE_STEP);
+  CHECK_EQ(rules.maxScore, MAX_SCORE);
+  CHECK_EQ(rules.speedDelay, SPEED_DELAY);
+  CHECK_EQ(FastLED.count(), NUM_STRIPS);
+
+  press(0, 'L');
+  for (int k = 0; k < 5000 && globalState != G_PLAYING; k++) tick();
+  CHECK_EQ(globalState, G_PLAYING);
+
+  StripGame &g = game[0];
+  int points = 0, lastSum = 0;
+  for (int k = 0; k < 600000 && globalState == G_PLAYING; k++) {
+    tick();
+    int sum = g.scoreL + g.scoreR;
+    if (sum == lastSum) continue;
+    CHECK_EQ(sum - lastSum, SCORE_STEP);
+    lastSum = sum;
+    points++;
+    if (g.state == PLAYING)
+      CHECK_EQ(g.zoneL, GAME_MODE::zoneShift(g.scoreL));
+  }
+  CHECK(points >= MAX_SCORE / SCORE_STEP);
+  CHECK(g.scoreL >= MAX_SCORE || g.scoreR >= MAX_SCORE);
+  CHECK_EQ(globalState, G_GAME_OVER_ANIM);
+  checkMatchEnd(laneColor(0, g.scoreL >= MAX_SCORE ? PAL_LEFT : PAL_RIGHT));
+  for (int k = 0; k < 20000 && globalState != G_DEMO; k++) tick();
+  CHECK_EQ(globalState, G_DEMO);
+  checkDemo();
+
+  printf("VARIANT %d: %d lanes, %d points on lane 0\n", VARIANT, NUM_STRIPS, points);
+  return report("variants");
+}